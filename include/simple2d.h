@@ -48,6 +48,38 @@ extern "C" {
 #define S2D_WARN  2
 #define S2D_ERROR 3
 
+// Log queue: slots (a power of two), and longest message including the terminator
+#define S2D_LOG_QUEUE_SIZE   256
+#define S2D_LOG_MESSAGE_SIZE 1024
+
+// Most events recorded by a single thread in a trace
+#define S2D_TRACE_MAX_EVENTS (1 << 20)
+
+// Profiling zones: most tracked, and the slowest shown in the diagnostics overlay
+#define S2D_PROFILE_MAX_ZONES     64
+#define S2D_PROFILE_OVERLAY_ZONES 8
+
+// Dirty rectangle mode: most damaged regions per frame, and the fraction of
+// the window damaged past which it's all drawn again
+#define S2D_DIRTY_MAX_RECTS   16
+#define S2D_DIRTY_FULL_REDRAW 0.5
+
+// Main callbacks per second while the window is hidden
+#define S2D_HIDDEN_CALLBACK_RATE 10
+
+// Viewport modes, for how content fits the window when it's resized
+#define S2D_FIXED   1  // keep the original size at the top left, unscaled
+#define S2D_EXPAND  2  // grow with the window, unscaled (default)
+#define S2D_SCALE   3  // scale the original size to fit, keeping its aspect ratio
+#define S2D_STRETCH 4  // scale the original size to fill
+
+// End a profiling zone when the enclosing scope exits (GCC and Clang)
+#define S2D_PROFILE_CONCAT_(a, b) a ## b
+#define S2D_PROFILE_CONCAT(a, b) S2D_PROFILE_CONCAT_(a, b)
+#define S2D_PROFILE_SCOPE(name) \
+  const char *S2D_PROFILE_CONCAT(s2d_profile_zone_, __LINE__) \
+    __attribute__((cleanup(S2D_ProfileEndScope), unused)) = (S2D_ProfileBegin(name), name)
+
 // Positions
 #define S2D_CENTER       1
 #define S2D_TOP_LEFT     2
@@ -111,6 +143,41 @@ extern "C" {
 #define S2D_BUTTON_DPAD_RIGHT     SDL_GAMEPAD_BUTTON_DPAD_RIGHT
 #define S2D_BUTTON_COUNT          SDL_GAMEPAD_BUTTON_COUNT
 
+// Maximum number of game controllers tracked at once
+#define S2D_MAX_CONTROLLERS 8
+
+// Number of voices in the mixer-wide pool, for overlapping (polyphonic) audio
+#define S2D_AUDIO_VOICES 32
+
+// Default memory budget for cached audio data, in bytes
+#define S2D_AUDIO_CACHE_BUDGET (64 * 1024 * 1024)
+
+// Window size of the mixer output spectrum, a power of two
+#define S2D_AUDIO_FFT_SIZE 1024
+
+// Initial size of the per-frame scratch arena, in bytes
+#define S2D_FRAME_ARENA_SIZE (256 * 1024)
+
+// Asset packs: maximum mounted at once, file magic, and format version
+#define S2D_MAX_PACKS 8
+#define S2D_PACK_MAGIC "S2DPACK"
+#define S2D_PACK_VERSION 1
+
+// Returned by `S2D_BeginStartupPhase()` once startup has finished, since any
+// tick count, even 0, can be a phase's start time
+#define S2D_STARTUP_PHASE_NONE UINT64_MAX
+
+// Subsystems, started on first use or with `S2D_StartSubsystems()`
+#define S2D_SUBSYSTEM_AUDIO       1  // SDL audio and SDL_mixer
+#define S2D_SUBSYSTEM_TEXT        2  // SDL_ttf
+#define S2D_SUBSYSTEM_CONTROLLERS 4  // SDL gamepads
+#define S2D_SUBSYSTEM_ALL         7
+
+// Event handlers, used when dispatching, recording, and replaying input
+#define S2D_ON_KEY        1
+#define S2D_ON_MOUSE      2
+#define S2D_ON_CONTROLLER 3
+
 // Type Definitions ////////////////////////////////////////////////////////////
 
 // S2D_Event
@@ -156,6 +223,7 @@ typedef struct {
   int width;
   int height;
   int mode;
+  float pixel_scale;  // pixels drawn per unit when scaling, 0 for the display scale
 } S2D_Viewport;
 
 // S2D_Window
@@ -181,11 +249,61 @@ typedef struct {
   uint64_t frames;
   double fps;
   bool close;
+  bool hidden;  // minimized, occluded, or hidden
 } S2D_Window;
 
+// S2D_PackHeader, at the start of an asset pack (all fields in the byte order
+// of the machine that built it, so packs aren't portable across byte orders)
+typedef struct {
+  char magic[8];          // S2D_PACK_MAGIC, NUL-padded
+  uint32_t version;
+  uint32_t count;         // number of assets
+  uint64_t index_offset;  // array of `count` S2D_PackEntry, sorted by hash
+  uint64_t names_offset;  // normalized asset paths, not NUL-terminated
+  uint64_t names_size;
+} S2D_PackHeader;
+
+// S2D_PackEntry, an asset in a pack's index
+typedef struct {
+  uint64_t hash;         // S2D_HashAssetPath() of the asset's path
+  uint64_t offset;       // asset bytes, from the start of the pack
+  uint64_t size;
+  uint32_t name_offset;  // path, from the start of the names
+  uint32_t name_len;
+} S2D_PackEntry;
+
+// S2D_TextureCacheStats, counters for the decoded texture cache
+typedef struct {
+  uint64_t hits;           // images loaded from the cache
+  uint64_t misses;         // images not yet cached
+  uint64_t rejected;       // entries that were stale or invalid
+  uint64_t stores;         // images decoded and written to the cache
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+} S2D_TextureCacheStats;
+
+// S2D_Pool, a slab allocator of fixed-size objects with a free list
+typedef struct S2D_Pool {
+  const char *name;
+  size_t object_size;
+  int per_slab;           // objects allocated together in each slab
+  void **slabs;
+  int slab_count;
+  int slab_capacity;
+  void *free_list;        // free objects, linked through their first word
+  int capacity;           // objects in all slabs
+  int live;               // objects currently allocated
+  int high_water;         // most objects allocated at once
+  bool registered;
+  struct S2D_Pool *next;  // next pool that has allocated
+} S2D_Pool;
+
+// Define a pool of objects of the given type
+#define S2D_POOL(type, name, per_slab) { name, sizeof(type), per_slab }
+
 // S2D_Image
 typedef struct {
-  const char *path;
+  const char *path;  // interned
   SDL_Surface *surface;
   SDL_Texture *texture;
   S2D_Color color;
@@ -203,15 +321,18 @@ typedef struct {
   float rotate;  // Rotation angle in degrees
   float rx;      // X coordinate to be rotated around
   float ry;      // Y coordinate to be rotated around
+  int live_index;  // position in the list of live images
 } S2D_Image;
 
 // S2D_Text
 typedef struct {
   char *msg;
+  size_t msg_capacity;  // allocated size of `msg`, reused when set
   SDL_Surface *surface;
   SDL_Texture *texture;
-  const char *font;
+  const char *font;     // interned
   TTF_Font *font_data;
+  size_t font_bytes;    // size of the font file
   S2D_Color color;
   int x;
   int y;
@@ -220,21 +341,208 @@ typedef struct {
   float rotate;  // Rotation angle in degrees
   float rx;      // X coordinate to be rotated around
   float ry;      // Y coordinate to be rotated around
+  int live_index;  // position in the list of live text
 } S2D_Text;
 
+// S2D_Layer, content cached in a render target texture, drawn again only
+// when dirty and composited with a single draw
+typedef struct {
+  SDL_Texture *texture;
+  S2D_Color color;
+  int x;
+  int y;
+  int width;
+  int height;
+  bool fit_window;     // sized to follow the window
+  float scale;         // display scale the texture was sized at
+  bool dirty;
+  uint64_t redraws;    // times the content was drawn
+  uint64_t deferred;   // texture uploads deferred when drawing began
+  SDL_Texture *prev_target;  // render target to restore when drawing ends
+  int live_index;  // position in the list of live layers
+} S2D_Layer;
+
+// S2D_AudioData, loaded audio shared between S2D_Audio with the same path
+typedef struct {
+  const char *path;  // interned
+  uint32_t hash;
+  bool predecoded;
+  MIX_Audio *mix_audio;
+  size_t bytes;          // decoded PCM, or the loaded file when streamed
+  int refs;              // S2D_Audio using this data
+  uint64_t last_played;  // play order, for least-recently-played eviction
+} S2D_AudioData;
+
+// S2D_AudioCacheStats, counters for the shared audio data cache
+typedef struct {
+  int entries;         // audio data resident in memory
+  int referenced;      // entries in use by S2D_Audio
+  size_t bytes;        // memory held by all entries
+  size_t budget;
+  uint64_t hits;       // audio created from resident data
+  uint64_t misses;     // audio loaded from file
+  uint64_t evictions;  // unreferenced entries freed to fit the budget
+} S2D_AudioCacheStats;
+
 // S2D_Audio
 typedef struct {
-  char *path;
+  const char *path;  // interned
+  S2D_AudioData *data;
   MIX_Audio *mix_audio;
-  MIX_Track *mix_track;
+  MIX_Track *mix_track;  // NULL when playing on pooled voices
+  float gain;
+  int max_voices;  // overlapping instances allowed, 1 restarts on play
+  int priority;    // higher priority sounds steal voices from lower ones
+  bool predecoded;       // fully decoded into memory, or streamed from file
+  size_t decoded_bytes;  // bytes of decoded PCM held in memory
 } S2D_Audio;
 
+// S2D_AudioVoiceStats, counters for the pool of voices
+typedef struct {
+  int voices;        // voices in the pool
+  int active;        // voices currently playing or paused
+  uint64_t played;   // sounds started on a pooled voice
+  uint64_t stolen;   // voices stopped early to play another sound
+  uint64_t dropped;  // plays skipped because no voice could be stolen
+  uint64_t late;     // scheduled plays started after their requested frame
+} S2D_AudioVoiceStats;
+
+// S2D_AudioRenderStats, the cost of offline rendering
+typedef struct {
+  uint64_t frames;            // sample frames rendered
+  double seconds;             // time spent mixing
+  double realtime;            // audio duration rendered per second of mixing
+  double ns_per_frame;        // mixing cost per sample frame
+  double ns_per_voice_frame;  // mixing cost per sample frame per playing track
+} S2D_AudioRenderStats;
+
+// S2D_AudioAnalysis, levels and spectrum of the mixer output
+typedef struct {
+  float rms;    // root mean square level of the last mixed block
+  float peak;   // peak absolute sample of the last mixed block
+  float spectrum[S2D_AUDIO_FFT_SIZE / 2];  // magnitude per frequency bin
+  float bin_hz;   // width of each frequency bin
+  int64_t clock;  // audio clock at the end of the analyzed block
+} S2D_AudioAnalysis;
+
+// Callback generating PCM for an audio stream, called on the mixer thread.
+// Fills `frames` sample frames of interleaved float samples.
+typedef void (*S2D_AudioStreamCallback)(void *userdata, float *samples, int frames, int channels);
+
+// S2D_AudioStream, PCM generated by the application
+typedef struct {
+  SDL_AudioStream *sdl_stream;
+  MIX_Track *mix_track;
+  int freq;
+  int channels;
+  S2D_AudioStreamCallback callback;  // NULL when fed through the ring buffer
+  void *userdata;
+  float *ring;              // single-producer/single-consumer ring of samples
+  int ring_frames;          // capacity, a power of two
+  SDL_AtomicInt read;       // frames consumed, advanced by the mixer thread
+  SDL_AtomicInt write;      // frames produced, advanced by the writer
+  float *scratch;           // block handed to the mixer, sized like the ring
+  SDL_AtomicInt underruns;  // blocks padded with silence
+  SDL_AtomicInt underrun_frames;
+} S2D_AudioStream;
+
+// S2D_Controller, the state of a connected game controller
+typedef struct {
+  SDL_JoystickID id;
+  SDL_Gamepad *sdl_gamepad;
+  char name[64];                    // cached when the controller is added
+  bool connected;
+  int axes[S2D_AXIS_COUNT];         // filtered values, as last dispatched
+  int raw_axes[S2D_AXIS_COUNT];     // raw values, before deadzones
+  bool buttons[S2D_BUTTON_COUNT];
+} S2D_Controller;
+
+// S2D_FrameArenaStats, usage of the per-frame scratch arena
+typedef struct {
+  size_t used;        // bytes allocated this frame
+  size_t capacity;    // bytes available before falling back to the heap
+  size_t high_water;  // most bytes allocated in a single frame
+  uint64_t overflows; // allocations that fell back to the heap
+} S2D_FrameArenaStats;
+
+// S2D_UploadStats, texture uploads and those deferred by the per-frame budget
+typedef struct {
+  uint64_t uploads;          // textures uploaded, including preloads
+  uint64_t bytes;            // bytes of pixels uploaded
+  uint64_t preloads;         // textures uploaded ahead of their first draw
+  uint64_t deferred;         // draws deferred to a later frame
+  uint64_t deferred_frames;  // frames where a draw was deferred
+  int frame_uploads;         // in the last frame
+  size_t frame_bytes;        // in the last frame
+  int frame_deferred;        // in the last frame
+  size_t max_frame_bytes;    // most bytes uploaded in a single frame
+} S2D_UploadStats;
+
+// S2D_DirtyRectStats, partial redraws in dirty rectangle mode
+typedef struct {
+  uint64_t frames;        // drawn in dirty rectangle mode
+  uint64_t full_redraws;  // frames where the whole window was drawn
+  uint64_t idle_frames;   // frames where nothing changed
+  int commands;           // draws recorded in the last frame
+  int replayed;           // draws replayed into damaged regions in the last frame
+  int rects;              // damaged regions in the last frame
+  float damaged;          // fraction of the window drawn in the last frame
+} S2D_DirtyRectStats;
+
+// S2D_StartupPhase, a timed phase of startup, up to the first presented frame
+typedef struct {
+  char name[96];
+  double start_ms;     // from the start of `SDL_AppInit`
+  double duration_ms;
+  int depth;           // number of enclosing phases, like `S2D_Init` for assets
+} S2D_StartupPhase;
+
+// S2D_MemoryUsage, the number of resources of a kind and the bytes they use
+typedef struct {
+  int count;
+  size_t bytes;
+} S2D_MemoryUsage;
+
+// S2D_MemoryStats, memory used by live resources and Simple 2D itself
+typedef struct {
+  S2D_MemoryUsage image_surfaces;  // decoded pixels not yet uploaded
+  S2D_MemoryUsage image_textures;  // estimated GPU memory
+  S2D_MemoryUsage text_surfaces;
+  S2D_MemoryUsage text_textures;
+  S2D_MemoryUsage fonts;           // font file sizes
+  S2D_MemoryUsage audio;           // cached audio data: decoded PCM, or streamed files
+  S2D_MemoryUsage layers;          // render target textures
+  size_t pools;                    // slabs of every pool
+  size_t interned_strings;
+  size_t frame_arena;              // capacity
+  size_t total;
+} S2D_MemoryStats;
+
+// S2D_ProfileZone, a named zone's time in the last frame, and over time
+typedef struct {
+  const char *name;
+  int depth;      // number of enclosing zones when first seen
+  int calls;      // in the last frame
+  double ms;      // total in the last frame
+  double avg_ms;  // smoothed over recent frames
+  double max_ms;  // most in a single frame
+} S2D_ProfileZone;
+
+// S2D_LogStats, messages handled by the logger
+typedef struct {
+  int written;     // by the logging thread
+  int dropped;     // while the queue was full
+  int suppressed;  // by the per-call-site rate limit
+} S2D_LogStats;
+
 // S2D_App
 typedef struct {
   S2D_Window *window;
   MIX_Mixer *sdl_mixer;
   bool diagnostics;
+  bool headless;
   bool quit;
+  int subsystems;  // `S2D_SUBSYSTEM_*` flags of those started
 } S2D_App;
 
 // Make the Simple 2D app globally accessible
@@ -266,6 +574,24 @@ void S2D_Log(int type, const char *msg, ...);
  */
 void S2D_Error(const char *caller, const char *msg, ...);
 
+/*
+ * Logs standard messages to the console, from the given call site
+ */
+void S2D_LogAt(const char *file, int line, int type, const char *msg, ...);
+
+/*
+ * Logs Simple 2D errors to the console, with caller and message body, from
+ * the given call site
+ */
+void S2D_ErrorAt(const char *file, int line, const char *caller, const char *msg, ...);
+
+// Define before including to rate limit by source line instead of by the
+// caller's code address
+#ifdef S2D_LOG_CALL_SITES
+  #define S2D_Log(...)   S2D_LogAt(__FILE__, __LINE__, __VA_ARGS__)
+  #define S2D_Error(...) S2D_ErrorAt(__FILE__, __LINE__, __VA_ARGS__)
+#endif
+
 /*
  * Enable/disable logging of diagnostics
  */
@@ -281,203 +607,1100 @@ void S2D_Windows_EnableTerminalColors();
  */
 bool S2D_KeyIs(S2D_Event e, const char *key);
 
-// Shapes //////////////////////////////////////////////////////////////////////
+/*
+ * Start subsystems early, given `S2D_SUBSYSTEM_*` flags, instead of on first use
+ */
+bool S2D_StartSubsystems(int flags);
 
 /*
- * Rotate a point around a given point
- * Params:
- *   p      The point to rotate
- *   angle  The angle in degrees
- *   rx     The x coordinate to rotate around
- *   ry     The y coordinate to rotate around
+ * Get the subsystems started so far, as `S2D_SUBSYSTEM_*` flags
  */
-S2D_Point S2D_RotatePoint(S2D_Point p, float angle, float rx, float ry);
+int S2D_GetStartedSubsystems();
+
+// Logging /////////////////////////////////////////////////////////////////////
 
 /*
- * Get the point to be rotated around given a position in a rectangle
+ * Set the least severe message type logged: `S2D_INFO`, `S2D_WARN`, or `S2D_ERROR`
  */
-S2D_Point S2D_GetRectRotationPoint(int x, int y, int w, int h, int position);
+void S2D_SetLogLevel(int type);
 
 /*
- * Draw a triangle
+ * Set the most messages logged from a single call site each second (0, the
+ * default, is unlimited)
  */
-void S2D_DrawTriangle(
-  float x1, float y1,
-  float r1, float g1, float b1, float a1,
-  float x2, float y2,
-  float r2, float g2, float b2, float a2,
-  float x3, float y3,
-  float r3, float g3, float b3, float a3
-);
+void S2D_SetLogRateLimit(int per_second);
 
 /*
- * Draw a quad, using two triangles
+ * Also write log messages to a file, or stop if NULL
  */
-void S2D_DrawQuad(
-  float x1, float y1,
-  float r1, float g1, float b1, float a1,
-  float x2, float y2,
-  float r2, float g2, float b2, float a2,
-  float x3, float y3,
-  float r3, float g3, float b3, float a3,
-  float x4, float y4,
-  float r4, float g4, float b4, float a4
-);
+bool S2D_SetLogFile(const char *path);
 
 /*
- * Draw a line from a quad
+ * Start the logging thread, queuing messages to write in the background
  */
-void S2D_DrawLine(
-  float x1, float y1, float x2, float y2,
-  float width,
-  float r1, float g1, float b1, float a1,
-  float r2, float g2, float b2, float a2,
-  float r3, float g3, float b3, float a3,
-  float r4, float g4, float b4, float a4
-);
+bool S2D_StartLogThread();
 
 /*
- * Draw a circle from triangles
+ * Wait until every message queued so far has been written
  */
-void S2D_DrawCircle(
-  float x, float y, float radius, int sectors,
-  float r, float g, float b, float a
-);
+void S2D_FlushLog();
 
-// Image ///////////////////////////////////////////////////////////////////////
+/*
+ * Get the number of messages written, dropped, and suppressed by the rate limit
+ */
+void S2D_GetLogStats(S2D_LogStats *stats);
 
 /*
- * Create an image, given a file path
+ * Stop the logging thread, writing any queued messages
  */
-S2D_Image *S2D_CreateImage(const char *path);
+void S2D_StopLogThread();
+
+// Tracing /////////////////////////////////////////////////////////////////////
 
 /*
- * Rotate an image
+ * Start recording trace events, written as Chrome trace JSON when stopped
  */
-void S2D_RotateImage(S2D_Image *img, float angle, int position);
+bool S2D_StartTrace(const char *path);
 
 /*
- * Set the clipping rectangle for an image
+ * Returns true if trace events are being recorded
  */
-void S2D_ClipImage(S2D_Image *img, int x, int y, int width, int height);
+bool S2D_IsTracing();
 
 /*
- * Remove the clipping rectangle from an image
+ * Begin a traced span on the calling thread, given a static name
  */
-void S2D_UnclipImage(S2D_Image *img);
+void S2D_TraceBegin(const char *name);
 
 /*
- * Draw an image
+ * Begin a traced span with a detail, like an asset's path
  */
-void S2D_DrawImage(S2D_Image *img);
+void S2D_TraceBeginDetail(const char *name, const char *detail);
 
 /*
- * Free an image
+ * End the calling thread's most recent traced span
  */
-void S2D_FreeImage(S2D_Image *img);
+void S2D_TraceEnd();
 
-// Text ////////////////////////////////////////////////////////////////////////
+/*
+ * Stop recording and write the trace file
+ */
+bool S2D_StopTrace();
 
 /*
- * Create text, given a font file path, the message, and size
+ * Free every thread's trace buffer, once other threads that trace have stopped
  */
-S2D_Text *S2D_CreateText(const char *font, const char *msg, int size);
+void S2D_FreeTrace();
+
+// Profiling Zones /////////////////////////////////////////////////////////////
 
 /*
-* Set the text message
-*/
-void S2D_SetText(S2D_Text *txt, const char *msg, ...);
+ * Enable or disable profiling zones (also recorded in diagnostics mode)
+ */
+void S2D_EnableProfiler(bool status);
 
 /*
- * Rotate text
+ * Begin a profiling zone, given a name that stays valid, like a string literal
  */
-void S2D_RotateText(S2D_Text *txt, float angle, int position);
+void S2D_ProfileBegin(const char *name);
 
 /*
- * Draw text
+ * End the innermost profiling zone
  */
-void S2D_DrawText(S2D_Text *txt);
+void S2D_ProfileEnd();
 
 /*
- * Free the text
+ * End a zone begun with `S2D_PROFILE_SCOPE`, when it goes out of scope
  */
-void S2D_FreeText(S2D_Text *txt);
+void S2D_ProfileEndScope(const char **name);
 
-// Audio ///////////////////////////////////////////////////////////////////////
+/*
+ * Aggregate this frame's zones and start a new frame
+ */
+void S2D_EndProfileFrame();
 
 /*
- * Create audio, given an audio file path
+ * Get the zones seen so far, returning the number of zones
  */
-S2D_Audio *S2D_CreateAudio(const char *path);
+int S2D_GetProfileZones(const S2D_ProfileZone **list);
 
 /*
- * Play the audio
+ * Forget every zone seen so far
  */
-void S2D_PlayAudio(S2D_Audio *audio);
+void S2D_ResetProfiler();
 
 /*
- * Pause the audio
+ * Draw the slowest zones in the diagnostics overlay, starting at the given height
  */
-void S2D_PauseAudio(S2D_Audio *audio);
+void S2D_DrawProfileOverlay(float y);
+
+// Diagnostics Overlay /////////////////////////////////////////////////////////
 
 /*
- * Resume the audio
+ * Get the width of overlay text in pixels, at the given scale
  */
-void S2D_ResumeAudio(S2D_Audio *audio);
+float S2D_GetOverlayTextWidth(const char *text, float scale);
 
 /*
- * Stop the audio
+ * Draw text in the overlay's 3x5 pixel font, in renderer coordinates
  */
-void S2D_StopAudio(S2D_Audio *audio, int ms_fade);
+void S2D_DrawOverlayText(float x, float y, const char *text, float scale, S2D_Color color);
 
 /*
- * Get the audio's volume (percentage, 0-100)
+ * Draw a semi-transparent panel behind overlay text, in renderer coordinates
  */
-int S2D_GetAudioVolume(S2D_Audio *audio);
+void S2D_DrawOverlayPanel(float x, float y, float width, float height);
+
+// Input Recording /////////////////////////////////////////////////////////////
 
 /*
- * Set the audio volume by percentage (0-100)
+ * Dispatch an event to the user's `S2D_OnKey`, `S2D_OnMouse`, or
+ * `S2D_OnController` function, given one of the `S2D_ON_*` handlers
  */
-void S2D_SetAudioVolume(S2D_Audio *audio, int volume);
+void S2D_DispatchEvent(int handler, S2D_Event e);
 
 /*
- * Get the audio mixer volume (percentage, 0-100)
+ * Start recording all delivered input events to a binary file, tagged with
+ * frame number and timestamp (also enabled with `--record=<file>`)
  */
-int S2D_GetAudioMixerVolume();
+bool S2D_StartRecording(const char *path);
 
 /*
- * Set the audio mixer volume a given percentage (0-100)
+ * Stop recording input and close the recording file
  */
-void S2D_SetAudioMixerVolume(int volume);
+void S2D_StopRecording();
 
 /*
- * Free the audio
+ * Start replaying input from a recording, frame by frame, ignoring live input
+ * (also enabled with `--replay=<file>`). The app closes when the replay ends.
  */
-void S2D_FreeAudio(S2D_Audio *audio);
+bool S2D_StartReplay(const char *path);
 
-// Window //////////////////////////////////////////////////////////////////////
+/*
+ * Returns true if input is currently being replayed from a recording
+ */
+bool S2D_IsReplaying();
 
 /*
- * Create a window
+ * Record the mouse position for the current frame
  */
-S2D_Window *S2D_CreateWindow(
-  const char *title, int width, int height
-);
+void S2D_RecordMousePosition(int x, int y);
 
 /*
- * Show the window
+ * Deliver all recorded events for the current frame
  */
-bool S2D_ShowWindow();
+void S2D_ReplayFrame();
+
+// Controllers /////////////////////////////////////////////////////////////////
 
 /*
- * Map window to renderer coordinates
+ * Open and track a newly added controller
  */
-void S2D_WindowToRendererCoordinates(SDL_Vertex *vertices, int count);
+void S2D_AddController(SDL_JoystickID id);
 
 /*
- * Map window to renderer coordinates for a rectangle
+ * Close and stop tracking a removed controller
  */
-void S2D_WindowToRendererCoordinatesRect(SDL_FRect *rect);
+void S2D_RemoveController(SDL_JoystickID id);
+
+/*
+ * Update a controller axis from a raw value, applying deadzones and the change
+ * threshold before dispatching to `S2D_OnController`
+ */
+void S2D_ControllerAxis(SDL_JoystickID id, int axis, int value);
+
+/*
+ * Update a controller button, dispatching only actual state changes
+ */
+void S2D_ControllerButton(SDL_JoystickID id, int button, bool down);
+
+/*
+ * Apply an already filtered controller event to the state table (for replay)
+ */
+void S2D_ApplyControllerEvent(S2D_Event *e);
+
+/*
+ * Set the radial (stick) and axial (per-axis) deadzones, in axis units (0-32767)
+ */
+void S2D_SetControllerDeadzone(int radial, int axial);
+
+/*
+ * Set the minimum change in a filtered axis value before an event is dispatched
+ */
+void S2D_SetControllerAxisThreshold(int threshold);
+
+/*
+ * Get the table of controller slots; check `connected` for each slot
+ */
+const S2D_Controller *S2D_GetControllers(int *count);
+
+/*
+ * Get a connected controller's state, given its ID, or NULL if not found
+ */
+const S2D_Controller *S2D_GetController(int id);
+
+/*
+ * Get a controller's cached name, given its ID
+ */
+const char *S2D_GetControllerName(int id);
+
+/*
+ * Get a controller's filtered axis value, given its ID
+ */
+int S2D_GetControllerAxis(int id, int axis);
+
+/*
+ * Returns true if a controller's button is pressed, given its ID
+ */
+bool S2D_GetControllerButton(int id, int button);
+
+/*
+ * Close all open controllers
+ */
+void S2D_FreeControllers();
+
+// Asset Packs /////////////////////////////////////////////////////////////////
+
+/*
+ * Mount an asset pack by mapping it into memory. Assets are then loaded from
+ * the most recently mounted pack containing them, before the file system.
+ */
+bool S2D_MountPack(const char *path);
+
+/*
+ * Unmount every asset pack; free assets loaded from them first
+ */
+void S2D_UnmountPacks();
+
+/*
+ * Find an asset in the mounted packs, pointing `data` at its bytes
+ */
+bool S2D_FindPackAsset(const char *path, const void **data, size_t *size);
+
+/*
+ * Open an asset for reading from the mounted packs or the file system.
+ * Returns NULL if the asset doesn't exist.
+ */
+SDL_IOStream *S2D_OpenAsset(const char *path);
+
+/*
+ * Returns true if an asset exists in the mounted packs or the file system
+ */
+bool S2D_AssetExists(const char *path);
+
+/*
+ * Hash a normalized asset path, as stored in a pack's index
+ */
+uint64_t S2D_HashAssetPath(const char *path);
+
+// Memory Pools ////////////////////////////////////////////////////////////////
+
+/*
+ * Allocate a zeroed object from a pool, in constant time
+ */
+void *S2D_PoolAlloc(S2D_Pool *pool);
+
+/*
+ * Return an object to its pool, in constant time
+ */
+void S2D_PoolFree(S2D_Pool *pool, void *object);
+
+/*
+ * Free every slab of a pool
+ */
+void S2D_FreePool(S2D_Pool *pool);
+
+/*
+ * Free the slabs of every pool that has allocated
+ */
+void S2D_FreePools();
+
+/*
+ * Get the list of pools that have allocated, linked through `next`
+ */
+const S2D_Pool *S2D_GetPools();
+
+/*
+ * Intern a string, returning a shared, reference-counted copy. Equal strings
+ * return the same pointer. Release it with `S2D_ReleaseString()`.
+ */
+const char *S2D_InternString(const char *str);
+
+/*
+ * Release a reference to an interned string
+ */
+void S2D_ReleaseString(const char *str);
+
+/*
+ * Get the number of interned strings, and optionally the bytes they use
+ */
+int S2D_GetInternedStrings(size_t *bytes);
+
+// Memory Accounting ///////////////////////////////////////////////////////////
+
+/*
+ * Get the memory used by live images, text, fonts, audio, and layers, and by
+ * Simple 2D
+ */
+void S2D_GetMemoryStats(S2D_MemoryStats *stats);
+
+/*
+ * Write a report of memory use to a file, listing the largest resources by path
+ */
+void S2D_DumpMemory(FILE *f, int max_resources);
+
+// Frame Arena /////////////////////////////////////////////////////////////////
+
+/*
+ * Allocate transient memory, valid until the start of the next frame. Never
+ * free it. Returns NULL if out of memory.
+ */
+void *S2D_FrameAlloc(size_t size);
+
+/*
+ * Allocate a zeroed transient array, valid until the start of the next frame
+ */
+void *S2D_FrameCalloc(size_t count, size_t size);
+
+/*
+ * Format a transient string, valid until the start of the next frame
+ */
+char *S2D_FrameFormat(const char *fmt, ...);
+
+/*
+ * Format a transient string, given a variable argument list
+ */
+char *S2D_FrameVFormat(const char *fmt, va_list args);
+
+/*
+ * Reset the frame arena, releasing all transient allocations
+ */
+void S2D_ResetFrameArena();
+
+/*
+ * Get statistics for the frame arena, including its high-water mark
+ */
+void S2D_GetFrameArenaStats(S2D_FrameArenaStats *stats);
+
+/*
+ * Free the frame arena
+ */
+void S2D_FreeFrameArena();
+
+// Startup Profile /////////////////////////////////////////////////////////////
+
+/*
+ * Mark the start of startup, when `SDL_AppInit` is called
+ */
+void S2D_StartStartupProfile();
+
+/*
+ * Write the startup report as JSON to a file when the first frame is presented
+ */
+void S2D_SetStartupProfile(const char *path);
+
+/*
+ * Begin timing a startup phase, returning its start time
+ * (`S2D_STARTUP_PHASE_NONE` after startup)
+ */
+Uint64 S2D_BeginStartupPhase();
+
+/*
+ * End timing a startup phase, given its start time and a printf-style name
+ */
+void S2D_EndStartupPhase(Uint64 start, const char *name, ...);
+
+/*
+ * Finish profiling startup, logging and writing the report
+ */
+void S2D_FinishStartupProfile();
+
+/*
+ * Get the recorded startup phases, in the order they started
+ */
+int S2D_GetStartupPhases(const S2D_StartupPhase **list);
+
+/*
+ * Get the time from the start of `SDL_AppInit` to the first presented frame,
+ * in milliseconds (0 until then)
+ */
+double S2D_GetTimeToFirstFrame();
+
+/*
+ * Free the recorded startup phases
+ */
+void S2D_FreeStartupProfile();
+
+// Shapes //////////////////////////////////////////////////////////////////////
+
+/*
+ * Rotate a point around a given point
+ * Params:
+ *   p      The point to rotate
+ *   angle  The angle in degrees
+ *   rx     The x coordinate to rotate around
+ *   ry     The y coordinate to rotate around
+ */
+S2D_Point S2D_RotatePoint(S2D_Point p, float angle, float rx, float ry);
+
+/*
+ * Get the point to be rotated around given a position in a rectangle
+ */
+S2D_Point S2D_GetRectRotationPoint(int x, int y, int w, int h, int position);
+
+/*
+ * Draw a triangle
+ */
+void S2D_DrawTriangle(
+  float x1, float y1,
+  float r1, float g1, float b1, float a1,
+  float x2, float y2,
+  float r2, float g2, float b2, float a2,
+  float x3, float y3,
+  float r3, float g3, float b3, float a3
+);
+
+/*
+ * Draw a quad, using two triangles
+ */
+void S2D_DrawQuad(
+  float x1, float y1,
+  float r1, float g1, float b1, float a1,
+  float x2, float y2,
+  float r2, float g2, float b2, float a2,
+  float x3, float y3,
+  float r3, float g3, float b3, float a3,
+  float x4, float y4,
+  float r4, float g4, float b4, float a4
+);
+
+/*
+ * Draw a line from a quad
+ */
+void S2D_DrawLine(
+  float x1, float y1, float x2, float y2,
+  float width,
+  float r1, float g1, float b1, float a1,
+  float r2, float g2, float b2, float a2,
+  float r3, float g3, float b3, float a3,
+  float r4, float g4, float b4, float a4
+);
+
+/*
+ * Draw a circle from triangles
+ */
+void S2D_DrawCircle(
+  float x, float y, float radius, int sectors,
+  float r, float g, float b, float a
+);
+
+// Image ///////////////////////////////////////////////////////////////////////
+
+/*
+ * Create an image, given a file path
+ */
+S2D_Image *S2D_CreateImage(const char *path);
+
+/*
+ * Rotate an image
+ */
+void S2D_RotateImage(S2D_Image *img, float angle, int position);
+
+/*
+ * Set the clipping rectangle for an image
+ */
+void S2D_ClipImage(S2D_Image *img, int x, int y, int width, int height);
+
+/*
+ * Remove the clipping rectangle from an image
+ */
+void S2D_UnclipImage(S2D_Image *img);
+
+/*
+ * Draw an image
+ */
+void S2D_DrawImage(S2D_Image *img);
+
+/*
+ * Free an image
+ */
+void S2D_FreeImage(S2D_Image *img);
+
+/*
+ * Get the list of live images
+ */
+S2D_Image *const *S2D_GetLiveImages(int *count);
+
+// Texture Uploads /////////////////////////////////////////////////////////////
+
+/*
+ * Upload an image's texture ahead of its first draw
+ */
+bool S2D_PreloadImage(S2D_Image *img);
+
+/*
+ * Upload text's texture ahead of its first draw
+ */
+bool S2D_PreloadText(S2D_Text *txt);
+
+/*
+ * Set the per-frame texture upload budget, in bytes and textures (0 is unlimited)
+ */
+void S2D_SetUploadBudget(size_t bytes, int count);
+
+/*
+ * Set the color of the placeholder drawn while a texture's upload is deferred
+ */
+void S2D_SetUploadPlaceholder(S2D_Color color);
+
+/*
+ * Upload a surface to a texture, destroying the surface. Returns NULL if
+ * deferred by the budget (when `budgeted`) or on error.
+ */
+SDL_Texture *S2D_UploadSurface(SDL_Surface **surface, bool budgeted);
+
+/*
+ * Draw the placeholder for a deferred texture, given its renderer rectangle
+ */
+void S2D_DrawUploadPlaceholder(const SDL_FRect *rect);
+
+/*
+ * Start a new frame's upload budget
+ */
+void S2D_ResetUploadBudget();
+
+/*
+ * Returns true if a texture upload was deferred in this frame
+ */
+bool S2D_UploadsDeferred();
+
+/*
+ * Get texture upload statistics, including deferred uploads
+ */
+void S2D_GetUploadStats(S2D_UploadStats *stats);
+
+// Texture Cache ///////////////////////////////////////////////////////////////
+
+/*
+ * Enable the decoded texture cache, storing files in the given directory,
+ * or disable it given NULL
+ */
+void S2D_EnableTextureCache(const char *dir);
+
+/*
+ * Bypass the texture cache, always decoding images from their source
+ */
+void S2D_BypassTextureCache(bool bypass);
+
+/*
+ * Load an image's decoded pixels from the texture cache, or NULL on a miss
+ */
+SDL_Surface *S2D_LoadCachedSurface(const char *path);
+
+/*
+ * Store an image's decoded pixels in the texture cache, returning the surface
+ * to use, converted to the renderer's preferred format
+ */
+SDL_Surface *S2D_StoreCachedSurface(const char *path, SDL_Surface *surface);
+
+/*
+ * Get statistics for the texture cache
+ */
+void S2D_GetTextureCacheStats(S2D_TextureCacheStats *stats);
+
+/*
+ * Remember the renderer's preferred texture format for the texture cache,
+ * so images created before the renderer on later runs are cached in it
+ */
+void S2D_RememberTextureCacheFormat();
+
+// Text ////////////////////////////////////////////////////////////////////////
+
+/*
+ * Create text, given a font file path, the message, and size
+ */
+S2D_Text *S2D_CreateText(const char *font, const char *msg, int size);
+
+/*
+* Set the text message
+*/
+void S2D_SetText(S2D_Text *txt, const char *msg, ...);
+
+/*
+ * Rotate text
+ */
+void S2D_RotateText(S2D_Text *txt, float angle, int position);
+
+/*
+ * Draw text
+ */
+void S2D_DrawText(S2D_Text *txt);
+
+/*
+ * Free the text
+ */
+void S2D_FreeText(S2D_Text *txt);
+
+/*
+ * Get the list of live text
+ */
+S2D_Text *const *S2D_GetLiveTexts(int *count);
+
+// Dirty Rectangles ////////////////////////////////////////////////////////////
+
+/*
+ * Enable or disable dirty rectangle mode, drawing again only what changed
+ */
+void S2D_EnableDirtyRects(bool status);
+
+/*
+ * Mark a region of the window to be drawn again in dirty rectangle mode
+ */
+void S2D_AddDamage(float x, float y, float width, float height);
+
+/*
+ * Redraw the whole window on the next frame, recreating the back buffer if lost
+ */
+void S2D_InvalidateDirtyRects(bool textures_lost);
+
+/*
+ * Draw triangles in renderer coordinates, or record them in dirty rectangle mode
+ */
+void S2D_RenderGeometry(const SDL_Vertex *vertices, int count, const int *indices, int index_count);
+
+/*
+ * Draw a texture in renderer coordinates, or record it in dirty rectangle mode
+ */
+void S2D_RenderTexture(SDL_Texture *texture, const void *content, size_t content_size,
+                       const SDL_FRect *src, const SDL_FRect *dst,
+                       double angle, const SDL_FPoint *center, S2D_Color color);
+
+/*
+ * Begin a frame in dirty rectangle mode, returning false if not enabled
+ */
+bool S2D_BeginDirtyFrame();
+
+/*
+ * End a frame in dirty rectangle mode, drawing the damaged regions
+ */
+void S2D_EndDirtyFrame();
+
+/*
+ * Get statistics for dirty rectangle mode
+ */
+void S2D_GetDirtyRectStats(S2D_DirtyRectStats *stats);
+
+/*
+ * Free the back buffer and draw lists when quitting
+ */
+void S2D_FreeDirtyRects();
+
+// Layers //////////////////////////////////////////////////////////////////////
+
+/*
+ * Create a layer, given its size, or 0 to follow the window's size
+ */
+S2D_Layer *S2D_CreateLayer(int width, int height);
+
+/*
+ * Begin drawing a layer's content, returning true if it's dirty and should be
+ * drawn, followed by `S2D_EndLayer()`
+ */
+bool S2D_BeginLayer(S2D_Layer *layer);
+
+/*
+ * End drawing a layer's content
+ */
+void S2D_EndLayer(S2D_Layer *layer);
+
+/*
+ * Mark a layer's content as changed
+ */
+void S2D_InvalidateLayer(S2D_Layer *layer);
+
+/*
+ * Mark every layer's content as changed, recreating their textures if lost
+ */
+void S2D_InvalidateLayers(bool textures_lost);
+
+/*
+ * Draw a layer's cached content
+ */
+void S2D_DrawLayer(S2D_Layer *layer);
+
+/*
+ * Free a layer
+ */
+void S2D_FreeLayer(S2D_Layer *layer);
+
+/*
+ * Free layers left when quitting
+ */
+void S2D_FreeLayers();
+
+/*
+ * Get the list of live layers
+ */
+S2D_Layer *const *S2D_GetLiveLayers(int *count);
+
+// Audio ///////////////////////////////////////////////////////////////////////
+
+/*
+ * Set the mixer's output frequency, channels, and device buffer size in sample
+ * frames, given 0 to keep the default. Must be called before audio is created.
+ */
+void S2D_SetAudioFormat(int freq, int channels, int sample_frames);
+
+/*
+ * Open the mixer on the default playback device, if not already open
+ */
+bool S2D_OpenAudio();
+
+/*
+ * Get the mixer device's output latency in milliseconds
+ */
+float S2D_GetAudioLatency();
+
+/*
+ * Get the mixer device's output frequency, channels, and buffer size in sample frames
+ */
+bool S2D_GetAudioFormat(int *freq, int *channels, int *sample_frames);
+
+/*
+ * Create audio, given an audio file path (streamed)
+ */
+S2D_Audio *S2D_CreateAudio(const char *path);
+
+/*
+ * Create a sound, fully predecoded into memory so it plays without decoding
+ */
+S2D_Audio *S2D_CreateSound(const char *path);
+
+/*
+ * Create music, streamed and decoded from the file as it plays
+ */
+S2D_Audio *S2D_CreateMusic(const char *path);
+
+/*
+ * Get the number of bytes of decoded PCM held by the audio
+ */
+size_t S2D_GetAudioDecodedBytes(S2D_Audio *audio);
+
+/*
+ * Get the total number of bytes held by all cached audio: decoded PCM for
+ * predecoded audio, and the loaded file for streamed audio
+ */
+size_t S2D_GetTotalAudioDecodedBytes();
+
+/*
+ * Set the memory budget for cached audio data, in bytes of decoded PCM and
+ * loaded streamed files. Unreferenced audio data is evicted, least recently played first, to fit.
+ */
+void S2D_SetAudioCacheBudget(size_t bytes);
+
+/*
+ * Get statistics for the shared audio data cache
+ */
+void S2D_GetAudioCacheStats(S2D_AudioCacheStats *stats);
+
+/*
+ * Get the list of cached audio data
+ */
+S2D_AudioData *const *S2D_GetCachedAudio(int *count);
+
+/*
+ * Free all cached audio data
+ */
+void S2D_FreeAudioCache();
+
+/*
+ * Play the audio
+ */
+void S2D_PlayAudio(S2D_Audio *audio);
+
+/*
+ * Schedule the audio to play at a position on the audio clock, in sample frames
+ */
+bool S2D_PlayAudioAt(S2D_Audio *audio, int64_t frame);
+
+/*
+ * Get the audio clock, the number of sample frames mixed since the mixer opened
+ */
+int64_t S2D_GetAudioClock();
+
+/*
+ * Convert milliseconds to sample frames at the mixer's frequency
+ */
+int64_t S2D_AudioMSToFrames(int64_t ms);
+
+/*
+ * Convert sample frames at the mixer's frequency to milliseconds
+ */
+int64_t S2D_AudioFramesToMS(int64_t frames);
+
+/*
+ * Pause the audio
+ */
+void S2D_PauseAudio(S2D_Audio *audio);
+
+/*
+ * Resume the audio
+ */
+void S2D_ResumeAudio(S2D_Audio *audio);
+
+/*
+ * Stop the audio
+ */
+void S2D_StopAudio(S2D_Audio *audio, int ms_fade);
+
+/*
+ * Get the audio's volume (percentage, 0-100)
+ */
+int S2D_GetAudioVolume(S2D_Audio *audio);
+
+/*
+ * Set the audio volume by percentage (0-100)
+ */
+void S2D_SetAudioVolume(S2D_Audio *audio, int volume);
+
+/*
+ * Set the maximum number of overlapping voices the audio can play at once,
+ * and its priority when stealing voices from other sounds
+ */
+void S2D_SetAudioVoices(S2D_Audio *audio, int max_voices, int priority);
+
+/*
+ * Get statistics for the mixer-wide pool of voices
+ */
+void S2D_GetAudioVoiceStats(S2D_AudioVoiceStats *stats);
+
+/*
+ * Free the pool of voices
+ */
+void S2D_FreeAudioVoices();
+
+/*
+ * Get the audio mixer volume (percentage, 0-100)
+ */
+int S2D_GetAudioMixerVolume();
+
+/*
+ * Set the audio mixer volume a given percentage (0-100)
+ */
+void S2D_SetAudioMixerVolume(int volume);
+
+/*
+ * Render audio offline, with a mixer not attached to an audio device, or
+ * switch back to the device. Must be called while no audio or audio streams exist.
+ */
+void S2D_SetAudioOffline(bool offline);
+
+/*
+ * Render the mix of playing audio into a buffer of interleaved float samples,
+ * in offline mode. Returns the number of sample frames rendered, or -1 on error.
+ */
+int S2D_RenderAudio(float *buffer, int frames);
+
+/*
+ * Render the mix of playing audio for a duration to a float WAV file, in
+ * offline mode. Fails if the rendered data wouldn't fit in a WAV file (4 GiB).
+ */
+bool S2D_RenderAudioToWAV(const char *path, int ms);
+
+/*
+ * Get statistics for offline rendering
+ */
+void S2D_GetAudioRenderStats(S2D_AudioRenderStats *stats);
+
+/*
+ * Free the audio
+ */
+void S2D_FreeAudio(S2D_Audio *audio);
+
+// Audio Analysis //////////////////////////////////////////////////////////////
+
+/*
+ * Enable or disable level and spectrum analysis of the mixer output
+ */
+void S2D_EnableAudioAnalysis(bool enable);
+
+/*
+ * Get the most recent analysis of the mixer output, without locking.
+ * Returns false if no analysis is available yet.
+ */
+bool S2D_GetAudioAnalysis(S2D_AudioAnalysis *analysis);
+
+/*
+ * Analyze a block of mixed audio, called on the mixer thread
+ */
+void S2D_AnalyzeAudio(const float *pcm, int frames, int channels, int freq, int64_t clock);
+
+// Audio Streams ///////////////////////////////////////////////////////////////
+
+/*
+ * Create an audio stream playing PCM generated by the application, at the given
+ * frequency and channel count. If `callback` is NULL, the stream is fed from a
+ * ring buffer holding `buffer_frames` sample frames, using `S2D_WriteAudioStream()`.
+ */
+S2D_AudioStream *S2D_CreateAudioStream(int freq, int channels, int buffer_frames,
+                                       S2D_AudioStreamCallback callback, void *userdata);
+
+/*
+ * Write interleaved float samples to the stream's ring buffer, from a single
+ * thread. Returns the number of sample frames written, which may be fewer
+ * than requested if the ring buffer is full.
+ */
+int S2D_WriteAudioStream(S2D_AudioStream *stream, const float *samples, int frames);
+
+/*
+ * Get the number of sample frames that can be written without blocking
+ */
+int S2D_GetAudioStreamSpace(S2D_AudioStream *stream);
+
+/*
+ * Get the number of underruns (blocks padded with silence), and optionally
+ * the number of silent frames inserted
+ */
+int S2D_GetAudioStreamUnderruns(S2D_AudioStream *stream, int *frames);
+
+/*
+ * Play the audio stream
+ */
+void S2D_PlayAudioStream(S2D_AudioStream *stream);
+
+/*
+ * Stop the audio stream
+ */
+void S2D_StopAudioStream(S2D_AudioStream *stream);
+
+/*
+ * Set the volume of the audio stream (percentage, 0-100)
+ */
+void S2D_SetAudioStreamVolume(S2D_AudioStream *stream, int volume);
+
+/*
+ * Free the audio stream
+ */
+void S2D_FreeAudioStream(S2D_AudioStream *stream);
+
+/*
+ * Get the number of live audio streams, and optionally how many are playing
+ */
+int S2D_GetAudioStreamCount(int *playing);
+
+// Window //////////////////////////////////////////////////////////////////////
+
+/*
+ * Create a window
+ */
+S2D_Window *S2D_CreateWindow(
+  const char *title, int width, int height
+);
+
+/*
+ * Show the window
+ */
+bool S2D_ShowWindow();
+
+/*
+ * Map window to renderer coordinates
+ */
+void S2D_WindowToRendererCoordinates(SDL_Vertex *vertices, int count);
+
+/*
+ * Map window to renderer coordinates for a rectangle
+ */
+void S2D_WindowToRendererCoordinatesRect(SDL_FRect *rect);
+
+/*
+ * Size the viewport for its mode, and map window to viewport coordinates
+ */
+void S2D_UpdateViewport();
+
+/*
+ * Map window coordinates, like the mouse's position, to viewport coordinates
+ */
+void S2D_WindowToViewportCoordinates(float *x, float *y);
+
+/*
+ * Map a distance in window coordinates to the viewport
+ */
+void S2D_WindowToViewportDelta(float *dx, float *dy);
+
+/*
+ * Get the size of the frame being drawn, in renderer coordinates
+ */
+void S2D_GetFrameSize(int *w, int *h);
+
+/*
+ * Get the render target the frame is drawn into, or NULL for the window
+ */
+SDL_Texture *S2D_GetViewportTarget();
+
+/*
+ * Get the scale from renderer coordinates to the frame's target pixels
+ */
+float S2D_GetViewportRenderScale();
+
+/*
+ * Begin drawing a frame in the viewport, at its internal resolution when scaling
+ */
+void S2D_BeginViewportFrame();
+
+/*
+ * End drawing a frame in the viewport, scaling it to the window
+ */
+void S2D_EndViewportFrame();
+
+/*
+ * Recreate the viewport's target if lost with the renderer's device
+ */
+void S2D_InvalidateViewport(bool textures_lost);
+
+/*
+ * Free the viewport's target when quitting
+ */
+void S2D_FreeViewport();
+
+/*
+ * Set the main callback rate for the display, window visibility, and rendering mode
+ */
+void S2D_UpdateCallbackRate();
+
+/*
+ * Enable or disable on-demand rendering, drawing frames only when needed
+ */
+void S2D_EnableOnDemandRendering(bool status);
+
+/*
+ * Request a frame when rendering on demand, from any thread
+ */
+void S2D_RequestRedraw();
+
+/*
+ * Draw every frame while animating, even when rendering on demand
+ */
+void S2D_SetAnimating(bool status);
+
+/*
+ * Request a frame for an event, and track whether the window is hidden
+ */
+void S2D_HandleRedrawEvent(const SDL_Event *event);
+
+/*
+ * Returns true if a frame should be drawn
+ */
+bool S2D_ShouldRender();
+
+/*
+ * End a frame when rendering on demand, requesting another if work is pending
+ */
+void S2D_EndRedrawFrame();
+
+/*
+ * Get the number of main loop iterations without a frame
+ */
+uint64_t S2D_GetSkippedFrames();
 
 /*
  * Close the app
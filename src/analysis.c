@@ -0,0 +1,256 @@
+// analysis.c
+
+#include "../include/simple2d.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+  #include <xmmintrin.h>
+  #define S2D_ANALYSIS_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  #include <arm_neon.h>
+  #define S2D_ANALYSIS_NEON
+#endif
+
+#define FFT_SIZE S2D_AUDIO_FFT_SIZE
+#define FFT_BINS (S2D_AUDIO_FFT_SIZE / 2)
+
+// Set from the game thread, read on the mixer thread
+static SDL_AtomicInt enabled;
+
+// Tables, built once before analysis is first enabled
+static bool tables_ready = false;
+static float window[FFT_SIZE];        // Hann window
+static int bit_reverse[FFT_SIZE];
+static float twiddle_re[FFT_SIZE];    // per stage, contiguous: stage with half
+static float twiddle_im[FFT_SIZE];    // size `h` starts at offset `h - 1`
+
+// Mixer thread state: the most recent mono samples, and FFT work buffers
+static float history[FFT_SIZE];
+static int history_pos = 0;
+static float fft_re[FFT_SIZE];
+static float fft_im[FFT_SIZE];
+
+// Double-buffered results. The writer fills the buffer not being published,
+// then bumps the sequence; the published buffer is `sequence & 1`.
+static S2D_AudioAnalysis results[2];
+static SDL_AtomicInt sequence;
+
+
+/*
+ * Build the window, bit reversal, and twiddle tables
+ */
+static void init_tables() {
+  int bits = 0;
+  while ((1 << bits) < FFT_SIZE) bits++;
+
+  for (int i = 0; i < FFT_SIZE; i++) {
+    window[i] = 0.5f - 0.5f * cosf(2.f * (float)M_PI * i / (FFT_SIZE - 1));
+
+    int r = 0;
+    for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+    bit_reverse[i] = r;
+  }
+
+  for (int h = 1; h < FFT_SIZE; h <<= 1) {
+    for (int j = 0; j < h; j++) {
+      double angle = -M_PI * j / h;
+      twiddle_re[h - 1 + j] = (float)cos(angle);
+      twiddle_im[h - 1 + j] = (float)sin(angle);
+    }
+  }
+
+  tables_ready = true;
+}
+
+
+/*
+ * Compute the sum of squares and the peak absolute value of the samples
+ */
+static void measure_levels(const float *pcm, int count, float *sum_sq, float *peak) {
+  int i = 0;
+  float sum = 0.f, max = 0.f;
+
+#if defined(S2D_ANALYSIS_SSE)
+  __m128 vsum = _mm_setzero_ps(), vmax = _mm_setzero_ps();
+  const __m128 sign = _mm_set1_ps(-0.f);
+  for (; i + 4 <= count; i += 4) {
+    __m128 v = _mm_loadu_ps(&pcm[i]);
+    vsum = _mm_add_ps(vsum, _mm_mul_ps(v, v));
+    vmax = _mm_max_ps(vmax, _mm_andnot_ps(sign, v));
+  }
+  float lanes_sum[4], lanes_max[4];
+  _mm_storeu_ps(lanes_sum, vsum);
+  _mm_storeu_ps(lanes_max, vmax);
+  for (int l = 0; l < 4; l++) {
+    sum += lanes_sum[l];
+    if (lanes_max[l] > max) max = lanes_max[l];
+  }
+#elif defined(S2D_ANALYSIS_NEON)
+  float32x4_t vsum = vdupq_n_f32(0.f), vmax = vdupq_n_f32(0.f);
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t v = vld1q_f32(&pcm[i]);
+    vsum = vmlaq_f32(vsum, v, v);
+    vmax = vmaxq_f32(vmax, vabsq_f32(v));
+  }
+  sum = vaddvq_f32(vsum);
+  max = vmaxvq_f32(vmax);
+#endif
+
+  for (; i < count; i++) {
+    sum += pcm[i] * pcm[i];
+    float a = fabsf(pcm[i]);
+    if (a > max) max = a;
+  }
+
+  *sum_sq = sum;
+  *peak = max;
+}
+
+
+/*
+ * Perform the butterflies of one FFT stage, given the half size of its groups
+ */
+static void fft_stage(int h) {
+  const float *wr = &twiddle_re[h - 1];
+  const float *wi = &twiddle_im[h - 1];
+
+  for (int g = 0; g < FFT_SIZE; g += h * 2) {
+    float *ar = &fft_re[g], *ai = &fft_im[g];
+    float *br = &fft_re[g + h], *bi = &fft_im[g + h];
+    int j = 0;
+
+#if defined(S2D_ANALYSIS_SSE)
+    for (; j + 4 <= h; j += 4) {
+      __m128 vwr = _mm_loadu_ps(&wr[j]), vwi = _mm_loadu_ps(&wi[j]);
+      __m128 vbr = _mm_loadu_ps(&br[j]), vbi = _mm_loadu_ps(&bi[j]);
+      __m128 tr = _mm_sub_ps(_mm_mul_ps(vbr, vwr), _mm_mul_ps(vbi, vwi));
+      __m128 ti = _mm_add_ps(_mm_mul_ps(vbr, vwi), _mm_mul_ps(vbi, vwr));
+      __m128 var = _mm_loadu_ps(&ar[j]), vai = _mm_loadu_ps(&ai[j]);
+      _mm_storeu_ps(&ar[j], _mm_add_ps(var, tr));
+      _mm_storeu_ps(&ai[j], _mm_add_ps(vai, ti));
+      _mm_storeu_ps(&br[j], _mm_sub_ps(var, tr));
+      _mm_storeu_ps(&bi[j], _mm_sub_ps(vai, ti));
+    }
+#elif defined(S2D_ANALYSIS_NEON)
+    for (; j + 4 <= h; j += 4) {
+      float32x4_t vwr = vld1q_f32(&wr[j]), vwi = vld1q_f32(&wi[j]);
+      float32x4_t vbr = vld1q_f32(&br[j]), vbi = vld1q_f32(&bi[j]);
+      float32x4_t tr = vsubq_f32(vmulq_f32(vbr, vwr), vmulq_f32(vbi, vwi));
+      float32x4_t ti = vaddq_f32(vmulq_f32(vbr, vwi), vmulq_f32(vbi, vwr));
+      float32x4_t var = vld1q_f32(&ar[j]), vai = vld1q_f32(&ai[j]);
+      vst1q_f32(&ar[j], vaddq_f32(var, tr));
+      vst1q_f32(&ai[j], vaddq_f32(vai, ti));
+      vst1q_f32(&br[j], vsubq_f32(var, tr));
+      vst1q_f32(&bi[j], vsubq_f32(vai, ti));
+    }
+#endif
+
+    for (; j < h; j++) {
+      float tr = br[j] * wr[j] - bi[j] * wi[j];
+      float ti = br[j] * wi[j] + bi[j] * wr[j];
+      float xr = ar[j], xi = ai[j];
+      ar[j] = xr + tr; ai[j] = xi + ti;
+      br[j] = xr - tr; bi[j] = xi - ti;
+    }
+  }
+}
+
+
+/*
+ * Compute the magnitude spectrum of the windowed history into `spectrum`
+ */
+static void compute_spectrum(float *spectrum) {
+  // Window the history, oldest sample first, in bit-reversed order
+  for (int i = 0; i < FFT_SIZE; i++) {
+    int src = (history_pos + i) & (FFT_SIZE - 1);
+    int dst = bit_reverse[i];
+    fft_re[dst] = history[src] * window[i];
+    fft_im[dst] = 0.f;
+  }
+
+  for (int h = 1; h < FFT_SIZE; h <<= 1) fft_stage(h);
+
+  // Magnitudes, scaled so a full-scale sine peaks near 1. The number of bins
+  // is a power of two, so the vector loops leave no remainder.
+  const float scale = 4.f / FFT_SIZE;
+  int k = 0;
+
+#if defined(S2D_ANALYSIS_SSE)
+  __m128 vscale = _mm_set1_ps(scale);
+  for (; k + 4 <= FFT_BINS; k += 4) {
+    __m128 re = _mm_loadu_ps(&fft_re[k]), im = _mm_loadu_ps(&fft_im[k]);
+    __m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+    _mm_storeu_ps(&spectrum[k], _mm_mul_ps(mag, vscale));
+  }
+#elif defined(S2D_ANALYSIS_NEON)
+  float32x4_t vscale = vdupq_n_f32(scale);
+  for (; k + 4 <= FFT_BINS; k += 4) {
+    float32x4_t re = vld1q_f32(&fft_re[k]), im = vld1q_f32(&fft_im[k]);
+    float32x4_t mag = vsqrtq_f32(vaddq_f32(vmulq_f32(re, re), vmulq_f32(im, im)));
+    vst1q_f32(&spectrum[k], vmulq_f32(mag, vscale));
+  }
+#else
+  for (; k < FFT_BINS; k++) {
+    float re = fft_re[k], im = fft_im[k];
+    spectrum[k] = sqrtf(re * re + im * im) * scale;
+  }
+#endif
+}
+
+
+/*
+ * Analyze a block of mixed audio, called on the mixer thread after each mix
+ */
+void S2D_AnalyzeAudio(const float *pcm, int frames, int channels, int freq, int64_t clock) {
+  if (!SDL_GetAtomicInt(&enabled) || frames <= 0 || channels <= 0) return;
+
+  int seq = SDL_GetAtomicInt(&sequence);
+  S2D_AudioAnalysis *out = &results[(seq + 1) & 1];
+
+  float sum_sq, peak;
+  measure_levels(pcm, frames * channels, &sum_sq, &peak);
+  out->rms = sqrtf(sum_sq / (frames * channels));
+  out->peak = peak;
+
+  // Downmix to mono into the history
+  const float gain = 1.f / channels;
+  for (int f = 0; f < frames; f++) {
+    float sum = 0.f;
+    for (int c = 0; c < channels; c++) sum += pcm[f * channels + c];
+    history[history_pos] = sum * gain;
+    history_pos = (history_pos + 1) & (FFT_SIZE - 1);
+  }
+
+  compute_spectrum(out->spectrum);
+  out->bin_hz = (float)freq / FFT_SIZE;
+  out->clock = clock;
+
+  // Publish the filled buffer
+  SDL_SetAtomicInt(&sequence, seq + 1);
+}
+
+
+/*
+ * Enable or disable analysis of the mixer output
+ */
+void S2D_EnableAudioAnalysis(bool enable) {
+  if (enable && !tables_ready) init_tables();
+  SDL_SetAtomicInt(&enabled, enable ? 1 : 0);
+}
+
+
+/*
+ * Get the most recent analysis of the mixer output, without locking.
+ * Returns false if no analysis is available yet.
+ */
+bool S2D_GetAudioAnalysis(S2D_AudioAnalysis *analysis) {
+  if (!analysis) return false;
+
+  // Retry if the mixer thread started refilling the buffer while copying
+  for (int attempt = 0; attempt < 4; attempt++) {
+    int seq = SDL_GetAtomicInt(&sequence);
+    if (seq == 0) return false;
+    *analysis = results[seq & 1];
+    if (SDL_GetAtomicInt(&sequence) == seq) return true;
+  }
+  return false;
+}
@@ -0,0 +1,161 @@
+// arena.c
+
+#include "../include/simple2d.h"
+
+// Alignment of every allocation, suitable for any type (including SIMD)
+#define ARENA_ALIGN 16
+
+// A block of heap memory taken when the arena overflows during a frame
+typedef struct S2D_ArenaBlock {
+  struct S2D_ArenaBlock *next;
+  size_t size;
+} S2D_ArenaBlock;
+
+// The arena, a single buffer reset each frame
+static uint8_t *arena = NULL;
+static size_t arena_capacity = 0;
+static size_t arena_used = 0;
+static S2D_ArenaBlock *overflow = NULL;  // freed on reset
+static size_t overflow_bytes = 0;
+static size_t high_water = 0;            // most bytes used in a single frame
+static uint64_t overflows = 0;
+
+
+/*
+ * Round a size up to the arena's alignment
+ */
+static size_t align_size(size_t size) {
+  return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+
+/*
+ * Allocate transient memory from the frame arena. The memory is valid until
+ * the start of the next frame, and must not be freed. Returns NULL if out of memory.
+ */
+void *S2D_FrameAlloc(size_t size) {
+  size = align_size(size ? size : 1);
+
+  if (!arena) {
+    arena = (uint8_t *) SDL_aligned_alloc(ARENA_ALIGN, S2D_FRAME_ARENA_SIZE);
+    if (!arena) return NULL;
+    arena_capacity = S2D_FRAME_ARENA_SIZE;
+  }
+
+  if (arena_used + size <= arena_capacity) {
+    void *ptr = arena + arena_used;
+    arena_used += size;
+    return ptr;
+  }
+
+  // Out of room for this frame; take a block from the heap, and grow the
+  // arena when it's reset so later frames fit
+  size_t header = align_size(sizeof(S2D_ArenaBlock));
+  S2D_ArenaBlock *block = (S2D_ArenaBlock *) SDL_aligned_alloc(ARENA_ALIGN, header + size);
+  if (!block) return NULL;
+  block->next = overflow;
+  block->size = size;
+  overflow = block;
+  overflow_bytes += size;
+  overflows++;
+  return (uint8_t *)block + header;
+}
+
+
+/*
+ * Allocate a zeroed array from the frame arena
+ */
+void *S2D_FrameCalloc(size_t count, size_t size) {
+  if (size && count > SIZE_MAX / size) return NULL;
+  void *ptr = S2D_FrameAlloc(count * size);
+  if (ptr) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+
+/*
+ * Format a string into the frame arena, given a variable argument list
+ */
+char *S2D_FrameVFormat(const char *fmt, va_list args) {
+  va_list copy;
+  va_copy(copy, args);
+  int len = vsnprintf(NULL, 0, fmt, copy);
+  va_end(copy);
+  if (len < 0) return NULL;
+
+  char *str = (char *) S2D_FrameAlloc(len + 1);
+  if (str) vsnprintf(str, len + 1, fmt, args);
+  return str;
+}
+
+
+/*
+ * Format a string into the frame arena, valid until the start of the next frame
+ */
+char *S2D_FrameFormat(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  char *str = S2D_FrameVFormat(fmt, args);
+  va_end(args);
+  return str;
+}
+
+
+/*
+ * Reset the frame arena, releasing all transient allocations. Called at the
+ * start of each frame.
+ */
+void S2D_ResetFrameArena() {
+  size_t used = arena_used + overflow_bytes;
+  if (used > high_water) high_water = used;
+
+  while (overflow) {
+    S2D_ArenaBlock *next = overflow->next;
+    SDL_aligned_free(overflow);
+    overflow = next;
+  }
+
+  // Grow to fit everything the last frame needed, so steady-state frames
+  // never touch the heap
+  if (overflow_bytes > 0) {
+    size_t capacity = arena_capacity;
+    while (capacity < used) capacity *= 2;
+    uint8_t *grown = (uint8_t *) SDL_aligned_alloc(ARENA_ALIGN, capacity);
+    if (grown) {
+      SDL_aligned_free(arena);
+      arena = grown;
+      arena_capacity = capacity;
+      S2D_Log(S2D_INFO, "Frame arena grown to %zu bytes", capacity);
+    }
+  }
+
+  arena_used = 0;
+  overflow_bytes = 0;
+}
+
+
+/*
+ * Get statistics for the frame arena
+ */
+void S2D_GetFrameArenaStats(S2D_FrameArenaStats *stats) {
+  if (!stats) return;
+  stats->used = arena_used + overflow_bytes;
+  stats->capacity = arena_capacity;
+  stats->high_water = high_water > stats->used ? high_water : stats->used;
+  stats->overflows = overflows;
+}
+
+
+/*
+ * Free the frame arena
+ */
+void S2D_FreeFrameArena() {
+  S2D_ResetFrameArena();
+  if (arena && s2d_app.diagnostics) {
+    S2D_Log(S2D_INFO, "Frame arena high-water mark: %zu of %zu bytes (%llu overflows)",
+      high_water, arena_capacity, (unsigned long long)overflows);
+  }
+  SDL_aligned_free(arena);
+  arena = NULL;
+  arena_capacity = 0;
+}
@@ -2,53 +2,861 @@
 
 #include "../include/simple2d.h"
 
+// A voice in the mixer-wide pool of reusable tracks
+typedef struct {
+  MIX_Track *track;
+  S2D_Audio *owner;   // audio last played on this voice, or NULL if unused
+  int priority;
+  uint64_t started;   // play order, used to find the oldest voice
+  bool scheduled;     // reserved for a scheduled play that hasn't started
+  SDL_PropertiesID options;  // play options, created once per voice
+  float *delay;       // delay line for sample-accurate starts within a block
+  int delay_capacity; // in samples
+  int delay_len;      // in samples, 0 when not delayed
+  int delay_pos;
+} S2D_AudioVoice;
+
+static S2D_AudioVoice voices[S2D_AUDIO_VOICES];
+static int voice_count = 0;
+static uint64_t voice_plays = 0;
+static uint64_t voice_steals = 0;
+static uint64_t voice_drops = 0;
+
+// A play scheduled at a position on the audio clock
+typedef struct {
+  S2D_AudioVoice *voice;
+  Sint64 start;  // in sample frames
+} S2D_AudioSchedule;
+
+// Scheduled plays and the audio clock, guarded by the mixer lock
+static S2D_AudioSchedule schedule[S2D_AUDIO_VOICES];
+static int schedule_count = 0;
+static uint64_t schedule_late = 0;
+static Sint64 audio_clock = 0;  // sample frames mixed since the mixer opened
+
+// Requested mixer format, where 0 uses the device default
+static int mixer_freq = 0;
+static int mixer_channels = 0;
+static int mixer_sample_frames = 0;
+
+// Render offline with a mixer not attached to a device
+static bool mixer_offline = false;
+
+// Offline rendering statistics
+static uint64_t render_frames = 0;
+static uint64_t render_ns = 0;
+static uint64_t render_voice_frames = 0;  // frames rendered times voices playing
+
+// Pool of audio structures
+static S2D_Pool audio_pool = S2D_POOL(S2D_Audio, "audio", 128);
+static S2D_Pool audio_data_pool = S2D_POOL(S2D_AudioData, "audio data", 128);
+
+// Audio created and not yet freed, to count the tracks playing
+static S2D_Audio **audio_list = NULL;
+static int audio_count = 0;
+static int audio_capacity = 0;
+
+// Effective output format of the mixer device, once opened
+static SDL_AudioSpec device_spec;
+static int device_sample_frames = 0;
+static SDL_AudioSpec output_spec;  // the mixer's own output format
+
+// Shared cache of loaded audio data, keyed by path and decoding mode
+static S2D_AudioData **cache = NULL;
+static int cache_count = 0;
+static int cache_capacity = 0;
+static size_t cache_bytes = 0;  // memory held by all cached audio
+static size_t cache_budget = S2D_AUDIO_CACHE_BUDGET;
+static uint64_t cache_clock = 0;  // play order, for least-recently-played eviction
+static uint64_t cache_hits = 0;
+static uint64_t cache_misses = 0;
+static uint64_t cache_evictions = 0;
+
 
 /*
- * Create audio, given an audio file path
+ * Set the mixer's output frequency, channels, and device buffer size in sample
+ * frames, given 0 to keep the current or default value. Must be called before
+ * the mixer is opened, that is, before audio is created.
  */
-S2D_Audio *S2D_CreateAudio(const char *path) {
-  // Check if audio file exists
-  if (!S2D_FileExists(path)) {
-    S2D_Error("S2D_CreateAudio", "Audio file `%s` not found", path);
+void S2D_SetAudioFormat(int freq, int channels, int sample_frames) {
+  if (s2d_app.sdl_mixer) {
+    S2D_Error("S2D_SetAudioFormat", "Audio format must be set before audio is created");
+    return;
+  }
+  if (freq > 0) mixer_freq = freq;
+  if (channels > 0) mixer_channels = channels;
+  if (sample_frames > 0) mixer_sample_frames = sample_frames;
+}
+
+
+/*
+ * Render audio offline, with a mixer not attached to an audio device. The mix
+ * is only advanced by `S2D_RenderAudio()`. If the mixer is already open in the
+ * other mode, it's closed and opened again when audio is next created, so no
+ * audio or audio streams may exist.
+ */
+void S2D_SetAudioOffline(bool offline) {
+  if (offline == mixer_offline) return;
+
+  if (s2d_app.sdl_mixer) {
+    if (audio_count > 0 || S2D_GetAudioStreamCount(NULL) > 0) {
+      S2D_Error("S2D_SetAudioOffline", "Offline mode can't change while audio exists");
+      return;
+    }
+
+    // Cached data and voices belong to the mixer, so they go with it
+    S2D_FreeAudioVoices();
+    S2D_FreeAudioCache();
+    MIX_DestroyMixer(s2d_app.sdl_mixer);
+    s2d_app.sdl_mixer = NULL;
+    audio_clock = 0;
+    device_spec = output_spec = (SDL_AudioSpec) { 0 };
+    device_sample_frames = 0;
+    S2D_Log(S2D_INFO, "Audio mixer closed");
+  }
+  mixer_offline = offline;
+}
+
+
+/*
+ * Start scheduled plays that fall within the next block of mixed audio,
+ * delaying each voice by its offset into the block
+ */
+static void start_scheduled(Sint64 block_frames) {
+  int channels = output_spec.channels > 0 ? output_spec.channels : 2;
+
+  for (int i = 0; i < schedule_count; i++) {
+    S2D_AudioSchedule *entry = &schedule[i];
+    if (entry->start >= audio_clock + block_frames) continue;
+
+    S2D_AudioVoice *v = entry->voice;
+    Sint64 offset = entry->start - audio_clock;
+    if (offset < 0) {
+      offset = 0;
+      schedule_late++;
+    }
+    if (offset * channels > v->delay_capacity) offset = v->delay_capacity / channels;
+
+    v->delay_len = (int)offset * channels;
+    v->delay_pos = 0;
+    if (v->delay_len > 0) memset(v->delay, 0, v->delay_len * sizeof(float));
+
+    // Append silence so the delayed tail drains out of the delay line
+    SDL_SetNumberProperty(v->options, MIX_PROP_PLAY_APPEND_SILENCE_FRAMES_NUMBER, offset);
+    MIX_PlayTrack(v->track, v->options);
+    v->scheduled = false;
+
+    schedule[i--] = schedule[--schedule_count];
+  }
+}
+
+
+/*
+ * Called on the mixer thread after each block of audio is mixed
+ */
+static void SDLCALL post_mix(void *userdata, MIX_Mixer *mixer, const SDL_AudioSpec *spec, float *pcm, int samples) {
+  S2D_TraceBegin("Audio post-mix");
+  Sint64 frames = samples / spec->channels;
+  audio_clock += frames;
+
+  S2D_AnalyzeAudio(pcm, (int)frames, spec->channels, spec->freq, audio_clock);
+
+  // The next block is assumed to be the same size as this one
+  if (schedule_count > 0) start_scheduled(frames);
+  S2D_TraceEnd();
+}
+
+
+/*
+ * Open the mixer on the default playback device, using the requested format
+ */
+bool S2D_OpenAudio() {
+  if (s2d_app.sdl_mixer) return true;
+  if (!S2D_StartSubsystems(S2D_SUBSYSTEM_AUDIO)) return false;
+
+  // The device buffer size can only be requested through a hint
+  if (mixer_sample_frames > 0) {
+    char frames_str[16];
+    snprintf(frames_str, sizeof(frames_str), "%d", mixer_sample_frames);
+    SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, frames_str);
+  }
+
+  SDL_AudioSpec spec = { .format = SDL_AUDIO_F32, .channels = 2, .freq = 48000 };
+  if (mixer_channels > 0) spec.channels = mixer_channels;
+  if (mixer_freq > 0) spec.freq = mixer_freq;
+  bool custom = mixer_freq > 0 || mixer_channels > 0;
+
+  if (mixer_offline) {
+    s2d_app.sdl_mixer = MIX_CreateMixer(&spec);
+    if (!s2d_app.sdl_mixer) {
+      S2D_Error("MIX_CreateMixer", SDL_GetError());
+      return false;
+    }
+
+    // No device, so the output format is the mixer's and there's no latency
+    MIX_GetMixerFormat(s2d_app.sdl_mixer, &output_spec);
+    device_spec = output_spec;
+    device_sample_frames = 0;
+    if (!MIX_SetPostMixCallback(s2d_app.sdl_mixer, post_mix, NULL)) {
+      S2D_Error("MIX_SetPostMixCallback", SDL_GetError());
+    }
+
+    S2D_Log(S2D_INFO, "Offline audio mixer opened");
+    S2D_Log(S2D_INFO, "  frequency: %d", output_spec.freq);
+    S2D_Log(S2D_INFO, "  channels: %d", output_spec.channels);
+    return true;
+  }
+
+  Uint64 phase = S2D_BeginStartupPhase();
+  s2d_app.sdl_mixer = MIX_CreateMixerDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, custom ? &spec : NULL);
+  S2D_EndStartupPhase(phase, "MIX_CreateMixerDevice");
+  if (!s2d_app.sdl_mixer) {
+    S2D_Error("MIX_CreateMixerDevice", SDL_GetError());
+    return false;
+  }
+
+  // Query the format and buffer size the device actually opened with
+  SDL_AudioDeviceID device = (SDL_AudioDeviceID) SDL_GetNumberProperty(
+    MIX_GetMixerProperties(s2d_app.sdl_mixer), MIX_PROP_MIXER_DEVICE_NUMBER, 0
+  );
+  if (!device) device = SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK;
+  if (!SDL_GetAudioDeviceFormat(device, &device_spec, &device_sample_frames)) {
+    S2D_Error("SDL_GetAudioDeviceFormat", SDL_GetError());
+    device_sample_frames = 0;
+  }
+
+  // Track the audio clock and start scheduled plays after each mixed block
+  MIX_GetMixerFormat(s2d_app.sdl_mixer, &output_spec);
+  if (!MIX_SetPostMixCallback(s2d_app.sdl_mixer, post_mix, NULL)) {
+    S2D_Error("MIX_SetPostMixCallback", SDL_GetError());
+  }
+
+  S2D_Log(S2D_INFO, "Audio device opened");
+  S2D_Log(S2D_INFO, "  frequency: %d", device_spec.freq);
+  S2D_Log(S2D_INFO, "  channels: %d", device_spec.channels);
+  S2D_Log(S2D_INFO, "  sample_frames: %d", device_sample_frames);
+  S2D_Log(S2D_INFO, "  latency: %.2f ms", S2D_GetAudioLatency());
+
+  return true;
+}
+
+
+/*
+ * Get the mixer device's output latency in milliseconds, that is, the
+ * duration of its sample frame buffer
+ */
+float S2D_GetAudioLatency() {
+  if (device_spec.freq <= 0) return 0.f;
+  return device_sample_frames * 1000.f / device_spec.freq;
+}
+
+
+/*
+ * Get the mixer device's output frequency, channels, and buffer size in sample
+ * frames; returns false if the mixer is not open
+ */
+bool S2D_GetAudioFormat(int *freq, int *channels, int *sample_frames) {
+  if (!s2d_app.sdl_mixer) return false;
+  if (freq) *freq = device_spec.freq;
+  if (channels) *channels = device_spec.channels;
+  if (sample_frames) *sample_frames = device_sample_frames;
+  return true;
+}
+
+
+/*
+ * Delay a voice's output by its delay line length, called on the mixer thread
+ * for each block of the voice's audio in the mixer's format
+ */
+static void SDLCALL delay_voice(void *userdata, MIX_Track *track, const SDL_AudioSpec *spec, float *pcm, int samples) {
+  S2D_AudioVoice *v = (S2D_AudioVoice *) userdata;
+  if (v->delay_len == 0) return;
+
+  for (int i = 0; i < samples; i++) {
+    float in = pcm[i];
+    pcm[i] = v->delay[v->delay_pos];
+    v->delay[v->delay_pos] = in;
+    if (++v->delay_pos == v->delay_len) v->delay_pos = 0;
+  }
+}
+
+
+/*
+ * Create the pool of voices on first use
+ */
+static bool init_voices() {
+  if (voice_count > 0) return true;
+
+  for (int i = 0; i < S2D_AUDIO_VOICES; i++) {
+    MIX_Track *track = MIX_CreateTrack(s2d_app.sdl_mixer);
+    if (!track) {
+      S2D_Error("MIX_CreateTrack", SDL_GetError());
+      break;
+    }
+    voices[i] = (S2D_AudioVoice) { .track = track, .options = SDL_CreateProperties() };
+    SDL_SetNumberProperty(voices[i].options, MIX_PROP_PLAY_APPEND_SILENCE_FRAMES_NUMBER, 0);
+    MIX_SetTrackCookedCallback(track, delay_voice, &voices[i]);
+    voice_count++;
+  }
+
+  return voice_count > 0;
+}
+
+
+/*
+ * Returns true if the voice is playing or paused
+ */
+static bool voice_busy(S2D_AudioVoice *v) {
+  return v->owner && (v->scheduled || MIX_TrackPlaying(v->track) || MIX_TrackPaused(v->track));
+}
+
+
+/*
+ * Cancel scheduled plays on voices owned by the audio; call with the mixer locked
+ */
+static void cancel_scheduled(S2D_Audio *aud) {
+  for (int i = 0; i < schedule_count; i++) {
+    if (schedule[i].voice->owner == aud) {
+      schedule[i].voice->scheduled = false;
+      schedule[i--] = schedule[--schedule_count];
+    }
+  }
+}
+
+
+/*
+ * Find a voice to play the audio on: a free voice if the sound is under its
+ * voice limit, otherwise steal its own oldest voice, or the oldest voice with
+ * the lowest priority not higher than the sound's. A single-voice sound's own
+ * track counts against its limit, and is stopped to make room. Returns NULL
+ * if none.
+ */
+static S2D_AudioVoice *acquire_voice(S2D_Audio *aud) {
+  S2D_AudioVoice *own_oldest = NULL, *free_voice = NULL, *victim = NULL;
+  int own_active = 0;
+
+  for (int i = 0; i < voice_count; i++) {
+    S2D_AudioVoice *v = &voices[i];
+    if (!voice_busy(v)) {
+      if (!free_voice) free_voice = v;
+      continue;
+    }
+    if (v->owner == aud) {
+      own_active++;
+      if (!own_oldest || v->started < own_oldest->started) own_oldest = v;
+    }
+    if (v->priority <= aud->priority &&
+        (!victim || v->priority < victim->priority ||
+         (v->priority == victim->priority && v->started < victim->started))) {
+      victim = v;
+    }
+  }
+
+  bool own_track = aud->mix_track && (MIX_TrackPlaying(aud->mix_track) || MIX_TrackPaused(aud->mix_track));
+  if (own_track) own_active++;
+
+  if (own_active >= aud->max_voices && own_track) {
+    MIX_StopTrack(aud->mix_track, 0);
+    if (free_voice) return free_voice;
+  } else if (own_active >= aud->max_voices) {
+    victim = own_oldest;
+  } else if (free_voice) {
+    return free_voice;
+  }
+
+  if (!victim) return NULL;
+  if (victim->owner != aud) voice_steals++;  // restarting its own isn't stealing
+
+  // Stealing a voice also cancels its scheduled play, if any
+  if (victim->scheduled) {
+    for (int i = 0; i < schedule_count; i++) {
+      if (schedule[i].voice == victim) schedule[i] = schedule[--schedule_count];
+    }
+    victim->scheduled = false;
+  }
+  MIX_StopTrack(victim->track, 0);
+  return victim;
+}
+
+
+/*
+ * Take a voice from the pool and assign the audio to it; call with the mixer locked
+ */
+static S2D_AudioVoice *assign_voice(S2D_Audio *aud) {
+  S2D_AudioVoice *v = acquire_voice(aud);
+  if (!v) {
+    voice_drops++;
+    return NULL;
+  }
+
+  v->owner = aud;
+  v->priority = aud->priority;
+  v->started = ++voice_plays;
+  v->delay_len = 0;
+
+  if (!MIX_SetTrackAudio(v->track, aud->mix_audio)) {
+    S2D_Error("MIX_SetTrackAudio", SDL_GetError());
+    v->owner = NULL;
+    return NULL;
+  }
+  MIX_SetTrackGain(v->track, aud->gain);
+  return v;
+}
+
+
+/*
+ * Play the audio on a voice from the pool, allowing overlapping instances
+ */
+static void play_voice(S2D_Audio *aud) {
+  if (!init_voices()) return;
+
+  MIX_LockMixer(s2d_app.sdl_mixer);
+  S2D_AudioVoice *v = assign_voice(aud);
+  if (v) {
+    SDL_SetNumberProperty(v->options, MIX_PROP_PLAY_APPEND_SILENCE_FRAMES_NUMBER, 0);
+    if (!MIX_PlayTrack(v->track, v->options)) {
+      S2D_Error("MIX_PlayTrack", SDL_GetError());
+      v->owner = NULL;
+    }
+  }
+  MIX_UnlockMixer(s2d_app.sdl_mixer);
+}
+
+
+/*
+ * Get the audio clock, the number of sample frames mixed since the mixer opened
+ */
+int64_t S2D_GetAudioClock() {
+  if (!s2d_app.sdl_mixer) return 0;
+  MIX_LockMixer(s2d_app.sdl_mixer);
+  Sint64 clock = audio_clock;
+  MIX_UnlockMixer(s2d_app.sdl_mixer);
+  return clock;
+}
+
+
+/*
+ * Convert milliseconds to sample frames at the mixer's frequency
+ */
+int64_t S2D_AudioMSToFrames(int64_t ms) {
+  return output_spec.freq > 0 ? MIX_MSToFrames(output_spec.freq, ms) : 0;
+}
+
+
+/*
+ * Convert sample frames at the mixer's frequency to milliseconds
+ */
+int64_t S2D_AudioFramesToMS(int64_t frames) {
+  return output_spec.freq > 0 ? MIX_FramesToMS(output_spec.freq, frames) : 0;
+}
+
+
+/*
+ * Schedule the audio to play at a position on the audio clock, in sample
+ * frames. Playback starts on that exact frame, regardless of render timing.
+ */
+bool S2D_PlayAudioAt(S2D_Audio *aud, int64_t frame) {
+  if (!aud || !init_voices()) return false;
+  aud->data->last_played = ++cache_clock;
+
+  int channels = output_spec.channels > 0 ? output_spec.channels : 2;
+  int block_frames = device_sample_frames > 0 ? device_sample_frames : 1024;
+
+  MIX_LockMixer(s2d_app.sdl_mixer);
+
+  S2D_AudioVoice *v = assign_voice(aud);
+  if (!v) {
+    MIX_UnlockMixer(s2d_app.sdl_mixer);
+    return false;
+  }
+
+  // Size the delay line to cover an offset anywhere within a mixed block
+  int capacity = block_frames * 4 * channels;
+  if (v->delay_capacity < capacity) {
+    float *delay = (float *) realloc(v->delay, capacity * sizeof(float));
+    if (!delay) {
+      S2D_Error("S2D_PlayAudioAt", "Out of memory!");
+      v->owner = NULL;
+      MIX_UnlockMixer(s2d_app.sdl_mixer);
+      return false;
+    }
+    v->delay = delay;
+    v->delay_capacity = capacity;
+  }
+
+  v->scheduled = true;
+  schedule[schedule_count++] = (S2D_AudioSchedule) { .voice = v, .start = frame };
+
+  MIX_UnlockMixer(s2d_app.sdl_mixer);
+  return true;
+}
+
+
+/*
+ * Returns the number of bytes of decoded PCM held by predecoded audio.
+ * Predecoded audio is stored as 32-bit float samples in its source format.
+ */
+static size_t decoded_size(MIX_Audio *mix_audio) {
+  SDL_AudioSpec spec;
+  Sint64 frames = MIX_GetAudioDuration(mix_audio);
+  if (frames <= 0 || !MIX_GetAudioFormat(mix_audio, &spec)) return 0;
+  return (size_t)frames * spec.channels * sizeof(float);
+}
+
+
+/*
+ * Hash a path using FNV-1a
+ */
+static uint32_t hash_path(const char *path) {
+  uint32_t hash = 2166136261u;
+  for (const char *c = path; *c; c++) {
+    hash = (hash ^ (uint8_t)*c) * 16777619u;
+  }
+  return hash;
+}
+
+
+/*
+ * Remove a cached entry and destroy its audio data
+ */
+static void evict_audio_data(int index) {
+  S2D_AudioData *data = cache[index];
+  cache_bytes -= data->bytes;
+  cache_evictions++;
+  S2D_Log(S2D_INFO, "Audio `%s` evicted from cache (%zu bytes)", data->path, data->bytes);
+
+  MIX_DestroyAudio(data->mix_audio);
+  S2D_ReleaseString(data->path);
+  S2D_PoolFree(&audio_data_pool, data);
+  cache[index] = cache[--cache_count];
+}
+
+
+/*
+ * Evict unreferenced audio data, least recently played first, until the
+ * cache fits within its budget with `needed` more bytes
+ */
+static void trim_audio_cache(size_t needed) {
+  while (cache_bytes + needed > cache_budget) {
+    int lru = -1;
+    for (int i = 0; i < cache_count; i++) {
+      if (cache[i]->refs == 0 && (lru < 0 || cache[i]->last_played < cache[lru]->last_played)) {
+        lru = i;
+      }
+    }
+    if (lru < 0) break;  // everything left is in use
+    evict_audio_data(lru);
+  }
+}
+
+
+/*
+ * Get audio data for a path from the cache, loading it if not resident
+ */
+static S2D_AudioData *acquire_audio_data(const char *caller, const char *path, bool predecode) {
+  uint32_t hash = hash_path(path);
+
+  for (int i = 0; i < cache_count; i++) {
+    S2D_AudioData *data = cache[i];
+    if (data->hash == hash && data->predecoded == predecode && strcmp(data->path, path) == 0) {
+      data->refs++;
+      cache_hits++;
+      return data;
+    }
+  }
+  cache_misses++;
+
+  // Open the audio file from a mounted pack or the file system
+  SDL_IOStream *io = S2D_OpenAsset(path);
+  if (!io) {
+    S2D_Error(caller, "Audio file `%s` not found", path);
     return NULL;
   }
 
+  if (cache_count == cache_capacity) {
+    int capacity = cache_capacity ? cache_capacity * 2 : 16;
+    S2D_AudioData **entries = (S2D_AudioData **) realloc(cache, capacity * sizeof(S2D_AudioData *));
+    if (!entries) {
+      SDL_CloseIO(io);
+      return NULL;
+    }
+    cache = entries;
+    cache_capacity = capacity;
+  }
+
+  S2D_AudioData *data = (S2D_AudioData *) S2D_PoolAlloc(&audio_data_pool);
+  if (!data) {
+    SDL_CloseIO(io);
+    return NULL;
+  }
+
+  // Streamed audio reads from the stream while playing, so it stays open
+  Sint64 io_size = SDL_GetIOSize(io);
+  data->mix_audio = MIX_LoadAudio_IO(s2d_app.sdl_mixer, io, predecode, true);
+  if (!data->mix_audio) {
+    S2D_Error("MIX_LoadAudio_IO", SDL_GetError());
+    S2D_PoolFree(&audio_data_pool, data);
+    return NULL;
+  }
+
+  data->path = S2D_InternString(path);
+  data->hash = hash;
+  data->predecoded = predecode;
+  // Streamed audio still holds its loaded file, so it's charged that size
+  data->bytes = predecode ? decoded_size(data->mix_audio) : (io_size > 0 ? (size_t)io_size : 0);
+  data->refs = 1;
+  data->last_played = cache_clock;
+
+  // Make room for the new data, then add it even if still over budget
+  trim_audio_cache(data->bytes);
+  if (cache_bytes + data->bytes > cache_budget) {
+    S2D_Log(S2D_WARN, "Audio cache over budget loading `%s` (%zu of %zu bytes)",
+      path, cache_bytes + data->bytes, cache_budget);
+  }
+
+  cache[cache_count++] = data;
+  cache_bytes += data->bytes;
+  return data;
+}
+
+
+/*
+ * Release a reference to cached audio data; it stays resident for reuse until
+ * evicted to fit the budget
+ */
+static void release_audio_data(S2D_AudioData *data) {
+  if (!data || data->refs <= 0) return;
+  data->refs--;
+  trim_audio_cache(0);
+}
+
+
+/*
+ * Add audio to the list of live audio
+ */
+static bool track_audio(S2D_Audio *aud) {
+  if (audio_count == audio_capacity) {
+    int capacity = audio_capacity ? audio_capacity * 2 : 16;
+    S2D_Audio **list = (S2D_Audio **) realloc(audio_list, capacity * sizeof(S2D_Audio *));
+    if (!list) return false;
+    audio_list = list;
+    audio_capacity = capacity;
+  }
+  audio_list[audio_count++] = aud;
+  return true;
+}
+
+
+/*
+ * Remove audio from the list of live audio
+ */
+static void untrack_audio(S2D_Audio *aud) {
+  for (int i = 0; i < audio_count; i++) {
+    if (audio_list[i] == aud) {
+      audio_list[i] = audio_list[--audio_count];
+      break;
+    }
+  }
+
+  if (audio_count == 0) {
+    free(audio_list);
+    audio_list = NULL;
+    audio_capacity = 0;
+  }
+}
+
+
+/*
+ * Create the audio's own track, used when it plays one instance at a time
+ */
+static bool create_track(S2D_Audio *aud) {
+  aud->mix_track = MIX_CreateTrack(s2d_app.sdl_mixer);
+  if (!aud->mix_track) {
+    S2D_Error("MIX_CreateTrack", SDL_GetError());
+    return false;
+  }
+  MIX_SetTrackGain(aud->mix_track, aud->gain);
+  return true;
+}
+
+
+/*
+ * Create audio from a file, either predecoded fully into memory, or streamed
+ * and decoded as it plays. Audio data is shared between audio with the same path.
+ */
+static S2D_Audio *load_audio(const char *caller, const char *path, bool predecode) {
+  if (!path || path[0] == '\0') {
+    S2D_Error(caller, "Audio file `%s` not found", path ? path : "");
+    return NULL;
+  }
+
+  if (!S2D_OpenAudio()) return NULL;
+
   // Allocate the audio structure
-  S2D_Audio *aud = (S2D_Audio *) malloc(sizeof(S2D_Audio));
+  S2D_Audio *aud = (S2D_Audio *) S2D_PoolAlloc(&audio_pool);
   if (!aud) {
-    S2D_Error("S2D_CreateAudio", "Out of memory!");
+    S2D_Error(caller, "Out of memory!");
     return NULL;
   }
 
-  MIX_Audio *mix_audio = MIX_LoadAudio(s2d_app.sdl_mixer, path, false);
-  if (!mix_audio) {
-    S2D_Error("MIX_LoadAudio", SDL_GetError());
-    free(aud);
+  S2D_AudioData *data = acquire_audio_data(caller, path, predecode);
+  if (!data) {
+    S2D_PoolFree(&audio_pool, aud);
     return NULL;
   }
 
-  MIX_Track *mix_track = MIX_CreateTrack(s2d_app.sdl_mixer);
-  if (!mix_track) {
-    S2D_Error("MIX_CreateTrack", SDL_GetError());
-    MIX_DestroyAudio(mix_audio);
-    free(aud);
+  aud->gain = 1.f;
+  if (!create_track(aud)) {
+    release_audio_data(data);
+    S2D_PoolFree(&audio_pool, aud);
     return NULL;
   }
 
   // Initialize values
-  aud->path = strdup(path);
-  aud->mix_audio = mix_audio;
-  aud->mix_track = mix_track;
+  aud->path = S2D_InternString(path);
+  aud->data = data;
+  aud->mix_audio = data->mix_audio;
+  aud->max_voices = 1;
+  aud->priority = 0;
+  aud->predecoded = predecode;
+  aud->decoded_bytes = predecode ? data->bytes : 0;
 
+  if (!track_audio(aud)) {
+    S2D_Error(caller, "Out of memory!");
+    S2D_FreeAudio(aud);
+    return NULL;
+  }
+
+  S2D_Log(S2D_INFO, "Audio `%s` %s (%zu bytes decoded, %d references)",
+    path, predecode ? "predecoded" : "streamed", aud->decoded_bytes, data->refs);
+
+  return aud;
+}
+
+
+/*
+ * Create audio, timed as a startup phase if created before the first frame
+ */
+static S2D_Audio *create_audio(const char *caller, const char *path, bool predecode) {
+  Uint64 phase = S2D_BeginStartupPhase();
+  S2D_TraceBeginDetail(caller, path);
+  S2D_Audio *aud = load_audio(caller, path, predecode);
+  S2D_TraceEnd();
+  S2D_EndStartupPhase(phase, "%s(\"%s\")", caller, path);
   return aud;
 }
 
 
+/*
+ * Create audio, given an audio file path (streamed)
+ */
+S2D_Audio *S2D_CreateAudio(const char *path) {
+  return create_audio("S2D_CreateAudio", path, false);
+}
+
+
+/*
+ * Create a sound, fully predecoded into memory so it plays without decoding
+ */
+S2D_Audio *S2D_CreateSound(const char *path) {
+  return create_audio("S2D_CreateSound", path, true);
+}
+
+
+/*
+ * Create music, streamed and decoded from the file as it plays
+ */
+S2D_Audio *S2D_CreateMusic(const char *path) {
+  return create_audio("S2D_CreateMusic", path, false);
+}
+
+
+/*
+ * Get the number of bytes of decoded PCM held by the audio
+ */
+size_t S2D_GetAudioDecodedBytes(S2D_Audio *aud) {
+  return aud ? aud->decoded_bytes : 0;
+}
+
+
+/*
+ * Get the total number of bytes held by all cached audio: decoded PCM for
+ * predecoded audio, and the loaded file for streamed audio
+ */
+size_t S2D_GetTotalAudioDecodedBytes() {
+  return cache_bytes;
+}
+
+
+/*
+ * Set the memory budget for cached audio data, in bytes
+ */
+void S2D_SetAudioCacheBudget(size_t bytes) {
+  cache_budget = bytes;
+  trim_audio_cache(0);
+}
+
+
+/*
+ * Get statistics for the shared audio data cache
+ */
+void S2D_GetAudioCacheStats(S2D_AudioCacheStats *stats) {
+  if (!stats) return;
+  stats->entries = cache_count;
+  stats->referenced = 0;
+  for (int i = 0; i < cache_count; i++) {
+    if (cache[i]->refs > 0) stats->referenced++;
+  }
+  stats->bytes = cache_bytes;
+  stats->budget = cache_budget;
+  stats->hits = cache_hits;
+  stats->misses = cache_misses;
+  stats->evictions = cache_evictions;
+}
+
+
+/*
+ * Get the list of cached audio data, including unreferenced data not yet evicted
+ */
+S2D_AudioData *const *S2D_GetCachedAudio(int *count) {
+  if (count) *count = cache_count;
+  return cache;
+}
+
+
+/*
+ * Free all cached audio data
+ */
+void S2D_FreeAudioCache() {
+  while (cache_count > 0) evict_audio_data(cache_count - 1);
+  free(cache);
+  cache = NULL;
+  cache_capacity = 0;
+}
+
+
 /*
  * Play the audio
  */
 void S2D_PlayAudio(S2D_Audio *aud) {
   if (!aud) return;
+  aud->data->last_played = ++cache_clock;
+
+  // Polyphonic sounds play on a pooled voice instead of restarting
+  if (aud->max_voices > 1 || !aud->mix_track) {
+    play_voice(aud);
+    return;
+  }
+
+  // A single-voice sound replaces its instance scheduled on a pooled voice
+  if (voice_count > 0) {
+    MIX_LockMixer(s2d_app.sdl_mixer);
+    cancel_scheduled(aud);
+    for (int i = 0; i < voice_count; i++) {
+      if (voices[i].owner == aud) MIX_StopTrack(voices[i].track, 0);
+    }
+    MIX_UnlockMixer(s2d_app.sdl_mixer);
+  }
 
   // Assign input to this track before playing (required in SDL3_mixer)
   if (!MIX_SetTrackAudio(aud->mix_track, aud->mix_audio)) {
@@ -66,9 +874,12 @@ void S2D_PlayAudio(S2D_Audio *aud) {
  */
 void S2D_PauseAudio(S2D_Audio *aud) {
   if (!aud) return;
-  if (!MIX_PauseTrack(aud->mix_track)) {
+  if (aud->mix_track && !MIX_PauseTrack(aud->mix_track)) {
     S2D_Error("MIX_PauseTrack", SDL_GetError());
   }
+  for (int i = 0; i < voice_count; i++) {
+    if (voices[i].owner == aud) MIX_PauseTrack(voices[i].track);
+  }
 }
 
 
@@ -77,9 +888,12 @@ void S2D_PauseAudio(S2D_Audio *aud) {
  */
 void S2D_ResumeAudio(S2D_Audio *aud) {
   if (!aud) return;
-  if (!MIX_ResumeTrack(aud->mix_track)) {
+  if (aud->mix_track && !MIX_ResumeTrack(aud->mix_track)) {
     S2D_Error("MIX_ResumeTrack", SDL_GetError());
   }
+  for (int i = 0; i < voice_count; i++) {
+    if (voices[i].owner == aud) MIX_ResumeTrack(voices[i].track);
+  }
 }
 
 
@@ -91,9 +905,18 @@ void S2D_StopAudio(S2D_Audio *aud, int ms_fade) {
   if (!aud) return;
   if (ms_fade < 0) ms_fade = 0;
 
-  if (!MIX_StopTrack(aud->mix_track, MIX_TrackMSToFrames(aud->mix_track, ms_fade))) {
+  MIX_LockMixer(s2d_app.sdl_mixer);
+  cancel_scheduled(aud);
+  MIX_UnlockMixer(s2d_app.sdl_mixer);
+
+  if (aud->mix_track && !MIX_StopTrack(aud->mix_track, MIX_TrackMSToFrames(aud->mix_track, ms_fade))) {
     S2D_Error("MIX_StopTrack", SDL_GetError());
   }
+  for (int i = 0; i < voice_count; i++) {
+    if (voices[i].owner == aud) {
+      MIX_StopTrack(voices[i].track, MIX_TrackMSToFrames(voices[i].track, ms_fade));
+    }
+  }
 }
 
 
@@ -102,8 +925,7 @@ void S2D_StopAudio(S2D_Audio *aud, int ms_fade) {
  */
 int S2D_GetAudioVolume(S2D_Audio *aud) {
   if (!aud) return 0;
-  const float gain = MIX_GetTrackGain(aud->mix_track);  // typically 0.0 .. 1.0
-  int volume = (int) SDL_roundf(gain * 100.0f);
+  int volume = (int) SDL_roundf(aud->gain * 100.0f);  // gain is typically 0.0 .. 1.0
 
   if (volume < 0) volume = 0;
   if (volume > 100) volume = 100;
@@ -119,10 +941,67 @@ void S2D_SetAudioVolume(S2D_Audio *aud, int volume) {
   if (volume < 0) volume = 0;
   if (volume > 100) volume = 100;
 
-  const float gain = (float) volume / 100.0f;
-  if (!MIX_SetTrackGain(aud->mix_track, gain)) {
+  aud->gain = (float) volume / 100.0f;
+  if (aud->mix_track && !MIX_SetTrackGain(aud->mix_track, aud->gain)) {
     S2D_Error("MIX_SetTrackGain", SDL_GetError());
   }
+  for (int i = 0; i < voice_count; i++) {
+    if (voices[i].owner == aud) MIX_SetTrackGain(voices[i].track, aud->gain);
+  }
+}
+
+
+/*
+ * Set the maximum number of overlapping voices the audio can play at once,
+ * and its priority when stealing voices from other sounds. Polyphonic audio
+ * plays only on pooled voices, so its own track is destroyed.
+ */
+void S2D_SetAudioVoices(S2D_Audio *aud, int max_voices, int priority) {
+  if (!aud) return;
+  aud->max_voices = max_voices < 1 ? 1 : max_voices;
+  aud->priority = priority;
+
+  if (aud->max_voices > 1 && aud->mix_track) {
+    MIX_DestroyTrack(aud->mix_track);
+    aud->mix_track = NULL;
+  } else if (aud->max_voices == 1 && !aud->mix_track) {
+    create_track(aud);
+  }
+}
+
+
+/*
+ * Get statistics for the mixer-wide pool of voices
+ */
+void S2D_GetAudioVoiceStats(S2D_AudioVoiceStats *stats) {
+  if (!stats) return;
+  stats->voices = voice_count;
+  stats->active = 0;
+  for (int i = 0; i < voice_count; i++) {
+    if (voice_busy(&voices[i])) stats->active++;
+  }
+  stats->played = voice_plays;
+  stats->stolen = voice_steals;
+  stats->dropped = voice_drops;
+  stats->late = schedule_late;
+}
+
+
+/*
+ * Free the pool of voices
+ */
+void S2D_FreeAudioVoices() {
+  if (s2d_app.sdl_mixer) MIX_LockMixer(s2d_app.sdl_mixer);
+  schedule_count = 0;
+  if (s2d_app.sdl_mixer) MIX_UnlockMixer(s2d_app.sdl_mixer);
+
+  for (int i = 0; i < voice_count; i++) {
+    MIX_DestroyTrack(voices[i].track);
+    SDL_DestroyProperties(voices[i].options);
+    free(voices[i].delay);
+    voices[i] = (S2D_AudioVoice) { 0 };
+  }
+  voice_count = 0;
 }
 
 
@@ -130,6 +1009,7 @@ void S2D_SetAudioVolume(S2D_Audio *aud, int volume) {
  * Get the audio mixer volume (percentage, 0-100)
  */
 int S2D_GetAudioMixerVolume() {
+  if (!S2D_OpenAudio()) return 0;
   const float gain = MIX_GetMixerGain(s2d_app.sdl_mixer);  // typically 0.0 .. 1.0
   int volume = (int) SDL_roundf(gain * 100.0f);
 
@@ -143,6 +1023,7 @@ int S2D_GetAudioMixerVolume() {
  * Set the audio mixer volume a given percentage (0-100)
  */
 void S2D_SetAudioMixerVolume(int volume) {
+  if (!S2D_OpenAudio()) return;
   if (volume < 0) volume = 0;
   if (volume > 100) volume = 100;
 
@@ -161,20 +1042,178 @@ void S2D_FreeAudio(S2D_Audio *aud) {
     return;
   }
 
+  // Release any pooled voices still playing or scheduled to play this audio
+  MIX_LockMixer(s2d_app.sdl_mixer);
+  cancel_scheduled(aud);
+  MIX_UnlockMixer(s2d_app.sdl_mixer);
+  for (int i = 0; i < voice_count; i++) {
+    if (voices[i].owner == aud) {
+      MIX_StopTrack(voices[i].track, 0);
+      MIX_SetTrackAudio(voices[i].track, NULL);
+      voices[i].owner = NULL;
+    }
+  }
+
   if (aud->mix_track) {
     MIX_DestroyTrack(aud->mix_track);
     aud->mix_track = NULL;
   }
+  untrack_audio(aud);
 
-  if (aud->mix_audio) {
-    MIX_DestroyAudio(aud->mix_audio);
+  if (aud->data) {
+    release_audio_data(aud->data);
+    aud->data = NULL;
     aud->mix_audio = NULL;
   }
 
   if (aud->path) {
-    free(aud->path);
+    S2D_ReleaseString(aud->path);
     aud->path = NULL;
   }
 
-  free(aud);
+  S2D_PoolFree(&audio_pool, aud);
+}
+
+
+/*
+ * Count the tracks currently playing: pooled voices, the audio's own tracks,
+ * and audio streams
+ */
+static int count_playing() {
+  int playing = 0;
+  S2D_GetAudioStreamCount(&playing);
+  for (int i = 0; i < voice_count; i++) {
+    if (voices[i].owner && MIX_TrackPlaying(voices[i].track)) playing++;
+  }
+  for (int i = 0; i < audio_count; i++) {
+    if (audio_list[i]->mix_track && MIX_TrackPlaying(audio_list[i]->mix_track)) playing++;
+  }
+  return playing;
+}
+
+
+/*
+ * Render the mix of currently playing audio into a buffer of interleaved
+ * float samples in the mixer's format, as fast as possible. Only available in
+ * offline mode. Returns the number of sample frames rendered, or -1 on error.
+ */
+int S2D_RenderAudio(float *buffer, int frames) {
+  if (!mixer_offline) {
+    S2D_Error("S2D_RenderAudio", "Audio can only be rendered in offline mode");
+    return -1;
+  }
+  if (!buffer || frames <= 0 || !S2D_OpenAudio()) return -1;
+
+  int frame_size = output_spec.channels * sizeof(float);
+  int playing = count_playing();
+
+  Uint64 start = SDL_GetTicksNS();
+  int bytes = MIX_Generate(s2d_app.sdl_mixer, buffer, frames * frame_size);
+  Uint64 elapsed = SDL_GetTicksNS() - start;
+
+  if (bytes < 0) {
+    S2D_Error("MIX_Generate", SDL_GetError());
+    return -1;
+  }
+
+  int rendered = bytes / frame_size;
+  render_frames += rendered;
+  render_ns += elapsed;
+  render_voice_frames += (uint64_t)rendered * playing;
+  return rendered;
+}
+
+
+/*
+ * Write a little-endian integer of the given size in bytes
+ */
+static void write_le(FILE *f, uint32_t value, int size) {
+  for (int i = 0; i < size; i++) fputc((value >> (i * 8)) & 0xFF, f);
+}
+
+
+/*
+ * Render the mix of currently playing audio for the given duration into a
+ * 32-bit float WAV file. Only available in offline mode.
+ */
+bool S2D_RenderAudioToWAV(const char *path, int ms) {
+  if (!path || ms < 0) return false;
+  if (!mixer_offline) {
+    S2D_Error("S2D_RenderAudioToWAV", "Audio can only be rendered in offline mode");
+    return false;
+  }
+  if (!S2D_OpenAudio()) return false;
+
+  // WAV sizes are 32-bit, counting the rest of the header after the RIFF size
+  int channels = output_spec.channels;
+  int frame_size = channels * sizeof(float);
+  Sint64 total = MIX_MSToFrames(output_spec.freq, ms);
+  if ((uint64_t)total * frame_size > UINT32_MAX - 50) {
+    S2D_Error("S2D_RenderAudioToWAV", "%d ms of audio is too long for a WAV file", ms);
+    return false;
+  }
+  uint32_t data_size = (uint32_t)(total * frame_size);
+
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    S2D_Error("S2D_RenderAudioToWAV", "Could not open `%s` for writing", path);
+    return false;
+  }
+
+  // RIFF header, with an IEEE float format chunk, which as a non-PCM format
+  // has the extended size field and a fact chunk with the length in frames
+  fwrite("RIFF", 1, 4, f);
+  write_le(f, 50 + data_size, 4);
+  fwrite("WAVEfmt ", 1, 8, f);
+  write_le(f, 18, 4);
+  write_le(f, 3, 2);  // WAVE_FORMAT_IEEE_FLOAT
+  write_le(f, channels, 2);
+  write_le(f, output_spec.freq, 4);
+  write_le(f, output_spec.freq * frame_size, 4);
+  write_le(f, frame_size, 2);
+  write_le(f, 32, 2);
+  write_le(f, 0, 2);  // no extension
+  fwrite("fact", 1, 4, f);
+  write_le(f, 4, 4);
+  write_le(f, (uint32_t) total, 4);
+  fwrite("data", 1, 4, f);
+  write_le(f, data_size, 4);
+
+  // Render in blocks, writing each one out
+  float block[1024 * 8];
+  int block_frames = (int)(sizeof(block) / frame_size);
+  uint64_t frames_before = render_frames, ns_before = render_ns;
+  bool ok = true;
+
+  for (Sint64 done = 0; done < total;) {
+    int n = total - done < block_frames ? (int)(total - done) : block_frames;
+    int rendered = S2D_RenderAudio(block, n);
+    if (rendered <= 0) { ok = false; break; }
+    fwrite(block, frame_size, rendered, f);
+    done += rendered;
+  }
+
+  fclose(f);
+
+  uint64_t frames = render_frames - frames_before;
+  double seconds = (render_ns - ns_before) / 1e9;
+  S2D_Log(S2D_INFO, "Rendered %d ms of audio to `%s` in %.3f ms (%.1fx realtime)",
+    ms, path, seconds * 1000.0,
+    seconds > 0 ? (double)frames / output_spec.freq / seconds : 0.0);
+
+  return ok;
+}
+
+
+/*
+ * Get statistics for offline rendering, accumulated over all rendered audio
+ */
+void S2D_GetAudioRenderStats(S2D_AudioRenderStats *stats) {
+  if (!stats) return;
+  stats->frames = render_frames;
+  stats->seconds = render_ns / 1e9;
+  stats->realtime = render_ns && output_spec.freq > 0 ?
+    (double)render_frames / output_spec.freq / stats->seconds : 0.0;
+  stats->ns_per_frame = render_frames ? (double)render_ns / render_frames : 0.0;
+  stats->ns_per_voice_frame = render_voice_frames ? (double)render_ns / render_voice_frames : 0.0;
 }
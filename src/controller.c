@@ -0,0 +1,309 @@
+// controller.c
+
+#include "../include/simple2d.h"
+
+// Table of controller state, indexed by slot
+static S2D_Controller controllers[S2D_MAX_CONTROLLERS];
+
+// Deadzones and change threshold, in axis units (0 to 32767)
+static int radial_deadzone = 7849;  // sticks, applied to the X/Y pair
+static int axial_deadzone  = 3855;  // every axis, applied independently
+static int axis_threshold  = 256;   // minimum change before dispatching
+
+
+/*
+ * Find the slot for a controller, given its joystick ID
+ */
+static S2D_Controller *find_controller(SDL_JoystickID id) {
+  for (int i = 0; i < S2D_MAX_CONTROLLERS; i++) {
+    if (controllers[i].connected && controllers[i].id == id) return &controllers[i];
+  }
+  return NULL;
+}
+
+
+/*
+ * Claim a free slot for a newly added controller, clearing its state
+ */
+static S2D_Controller *claim_controller(SDL_JoystickID id, const char *name) {
+  for (int i = 0; i < S2D_MAX_CONTROLLERS; i++) {
+    S2D_Controller *c = &controllers[i];
+    if (!c->connected) {
+      memset(c, 0, sizeof(S2D_Controller));
+      c->id = id;
+      c->connected = true;
+      snprintf(c->name, sizeof(c->name), "%s", name ? name : "Unknown");
+      return c;
+    }
+  }
+  return NULL;
+}
+
+
+/*
+ * Clamp a value to the range of an axis
+ */
+static int clamp_axis(float value) {
+  if (value >  32767.f) return  32767;
+  if (value < -32768.f) return -32768;
+  return (int)value;
+}
+
+
+/*
+ * Apply the axial deadzone to a single value, rescaling the remaining range
+ */
+static float apply_axial(float value) {
+  float mag = fabsf(value);
+  if (mag <= axial_deadzone) return 0.f;
+  float scaled = (mag - axial_deadzone) * 32767.f / (32767.f - axial_deadzone);
+  return value < 0 ? -scaled : scaled;
+}
+
+
+/*
+ * Compute the filtered value of an axis from the raw values, applying the
+ * radial deadzone to stick pairs and the axial deadzone to each axis
+ */
+static int filter_axis(const S2D_Controller *c, int axis) {
+  float value = c->raw_axes[axis];
+
+  int pair = -1;
+  switch (axis) {
+    case S2D_AXIS_LEFTX:  pair = S2D_AXIS_LEFTY;  break;
+    case S2D_AXIS_LEFTY:  pair = S2D_AXIS_LEFTX;  break;
+    case S2D_AXIS_RIGHTX: pair = S2D_AXIS_RIGHTY; break;
+    case S2D_AXIS_RIGHTY: pair = S2D_AXIS_RIGHTX; break;
+  }
+
+  if (pair >= 0 && radial_deadzone > 0) {
+    float other = c->raw_axes[pair];
+    float mag = sqrtf(value * value + other * other);
+    if (mag <= radial_deadzone) return 0;
+    float scale = (mag - radial_deadzone) / (32767.f - radial_deadzone);
+    if (scale > 1.f) scale = 1.f;
+    value = value / mag * scale * 32767.f;
+  }
+
+  return clamp_axis(apply_axial(value));
+}
+
+
+/*
+ * Dispatch an axis event if the filtered value changed beyond the threshold,
+ * or settled at rest or at either extreme
+ */
+static void update_axis(S2D_Controller *c, int axis) {
+  int value = filter_axis(c, axis);
+  int last = c->axes[axis];
+  if (value == last) return;
+
+  bool settled = value == 0 || value == 32767 || value == -32768;
+  if (!settled && abs(value - last) < axis_threshold) return;
+
+  c->axes[axis] = value;
+  S2D_Event event = {
+    .type = S2D_AXIS, .id = c->id, .name = c->name,
+    .axis = axis, .value = value
+  };
+  S2D_DispatchEvent(S2D_ON_CONTROLLER, event);
+}
+
+
+/*
+ * Open and track a newly added controller
+ */
+void S2D_AddController(SDL_JoystickID id) {
+  if (S2D_IsReplaying() || find_controller(id)) return;
+
+  SDL_Gamepad *pad = SDL_OpenGamepad(id);
+  if (!pad) {
+    S2D_Error("SDL_OpenGamepad", "SDL_OpenGamepad(%u) failed: %s", (unsigned)id, SDL_GetError());
+    return;
+  }
+
+  S2D_Controller *c = claim_controller(id, SDL_GetGamepadName(pad));
+  if (!c) {
+    S2D_Log(S2D_WARN, "Gamepad ignored, %d controllers already connected: id=%u",
+      S2D_MAX_CONTROLLERS, (unsigned)id);
+    SDL_CloseGamepad(pad);
+    return;
+  }
+  c->sdl_gamepad = pad;
+
+  S2D_Log(S2D_INFO, "Gamepad added: id=%u, name=%s", (unsigned)id, c->name);
+  S2D_Event event = {
+    .type = S2D_CONTROLLER_ADDED, .id = id, .name = c->name
+  };
+  S2D_DispatchEvent(S2D_ON_CONTROLLER, event);
+}
+
+
+/*
+ * Close and stop tracking a removed controller. Its cached name remains
+ * valid until the slot is reused by another controller.
+ */
+void S2D_RemoveController(SDL_JoystickID id) {
+  if (S2D_IsReplaying()) return;
+
+  S2D_Controller *c = find_controller(id);
+  if (!c) return;
+
+  S2D_Log(S2D_INFO, "Gamepad removed: id=%u, name=%s", (unsigned)id, c->name);
+  S2D_Event event = {
+    .type = S2D_CONTROLLER_REMOVED, .id = id, .name = c->name
+  };
+  S2D_DispatchEvent(S2D_ON_CONTROLLER, event);
+
+  if (c->sdl_gamepad) SDL_CloseGamepad(c->sdl_gamepad);
+  c->sdl_gamepad = NULL;
+  c->connected = false;
+}
+
+
+/*
+ * Update a controller axis from a raw value, dispatching filtered changes
+ */
+void S2D_ControllerAxis(SDL_JoystickID id, int axis, int value) {
+  if (S2D_IsReplaying() || axis < 0 || axis >= S2D_AXIS_COUNT) return;
+
+  S2D_Controller *c = find_controller(id);
+  if (!c) return;
+
+  c->raw_axes[axis] = value;
+  update_axis(c, axis);
+
+  // The radial deadzone rescales both axes of a stick together
+  switch (axis) {
+    case S2D_AXIS_LEFTX:  update_axis(c, S2D_AXIS_LEFTY);  break;
+    case S2D_AXIS_LEFTY:  update_axis(c, S2D_AXIS_LEFTX);  break;
+    case S2D_AXIS_RIGHTX: update_axis(c, S2D_AXIS_RIGHTY); break;
+    case S2D_AXIS_RIGHTY: update_axis(c, S2D_AXIS_RIGHTX); break;
+  }
+}
+
+
+/*
+ * Update a controller button, dispatching only actual state changes
+ */
+void S2D_ControllerButton(SDL_JoystickID id, int button, bool down) {
+  if (S2D_IsReplaying() || button < 0 || button >= S2D_BUTTON_COUNT) return;
+
+  S2D_Controller *c = find_controller(id);
+  if (!c || c->buttons[button] == down) return;
+
+  c->buttons[button] = down;
+  S2D_Event event = {
+    .type = down ? S2D_BUTTON_DOWN : S2D_BUTTON_UP, .id = id, .name = c->name,
+    .button = button
+  };
+  S2D_DispatchEvent(S2D_ON_CONTROLLER, event);
+}
+
+
+/*
+ * Apply an already filtered controller event to the state table, used when
+ * replaying recorded input. Points the event's name at the cached name.
+ */
+void S2D_ApplyControllerEvent(S2D_Event *e) {
+  S2D_Controller *c = find_controller(e->id);
+
+  switch (e->type) {
+    case S2D_CONTROLLER_ADDED:
+      if (!c) c = claim_controller(e->id, e->name);
+      break;
+    case S2D_CONTROLLER_REMOVED:
+      if (c) c->connected = false;
+      break;
+    case S2D_AXIS:
+      if (c && e->axis >= 0 && e->axis < S2D_AXIS_COUNT) {
+        c->raw_axes[e->axis] = c->axes[e->axis] = e->value;
+      }
+      break;
+    case S2D_BUTTON_DOWN:
+    case S2D_BUTTON_UP:
+      if (c && e->button >= 0 && e->button < S2D_BUTTON_COUNT) {
+        c->buttons[e->button] = e->type == S2D_BUTTON_DOWN;
+      }
+      break;
+  }
+
+  if (c) e->name = c->name;
+}
+
+
+/*
+ * Set the radial (stick) and axial (per-axis) deadzones, in axis units (0-32767)
+ */
+void S2D_SetControllerDeadzone(int radial, int axial) {
+  radial_deadzone = radial < 0 ? 0 : (radial > 32000 ? 32000 : radial);
+  axial_deadzone  = axial  < 0 ? 0 : (axial  > 32000 ? 32000 : axial);
+}
+
+
+/*
+ * Set the minimum change in a filtered axis value before an event is dispatched
+ */
+void S2D_SetControllerAxisThreshold(int threshold) {
+  axis_threshold = threshold < 0 ? 0 : threshold;
+}
+
+
+/*
+ * Get the table of controller slots; check `connected` for each slot. Starts
+ * controller support on first use, so IDs from the table can be queried.
+ */
+const S2D_Controller *S2D_GetControllers(int *count) {
+  S2D_StartSubsystems(S2D_SUBSYSTEM_CONTROLLERS);
+  if (count) *count = S2D_MAX_CONTROLLERS;
+  return controllers;
+}
+
+
+/*
+ * Get a connected controller's state, given its ID, or NULL if not found
+ */
+const S2D_Controller *S2D_GetController(int id) {
+  return find_controller((SDL_JoystickID)id);
+}
+
+
+/*
+ * Get a controller's cached name, given its ID
+ */
+const char *S2D_GetControllerName(int id) {
+  S2D_Controller *c = find_controller((SDL_JoystickID)id);
+  return c ? c->name : NULL;
+}
+
+
+/*
+ * Get a controller's filtered axis value, given its ID
+ */
+int S2D_GetControllerAxis(int id, int axis) {
+  S2D_Controller *c = find_controller((SDL_JoystickID)id);
+  if (!c || axis < 0 || axis >= S2D_AXIS_COUNT) return 0;
+  return c->axes[axis];
+}
+
+
+/*
+ * Returns true if a controller's button is pressed, given its ID
+ */
+bool S2D_GetControllerButton(int id, int button) {
+  S2D_Controller *c = find_controller((SDL_JoystickID)id);
+  if (!c || button < 0 || button >= S2D_BUTTON_COUNT) return false;
+  return c->buttons[button];
+}
+
+
+/*
+ * Close all open controllers
+ */
+void S2D_FreeControllers() {
+  for (int i = 0; i < S2D_MAX_CONTROLLERS; i++) {
+    if (controllers[i].sdl_gamepad) SDL_CloseGamepad(controllers[i].sdl_gamepad);
+    controllers[i].sdl_gamepad = NULL;
+    controllers[i].connected = false;
+  }
+}
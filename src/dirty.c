@@ -0,0 +1,449 @@
+// dirty.c
+
+#include "../include/simple2d.h"
+
+// A draw recorded in dirty rectangle mode, replayed into damaged regions
+typedef struct {
+  SDL_Rect bounds;       // renderer coordinates it covers
+  uint64_t signature;    // hash of everything affecting the pixels drawn
+  SDL_Texture *texture;  // NULL for geometry
+  SDL_Vertex *vertices;  // in the frame arena
+  int vertex_count;
+  int *indices;
+  int index_count;
+  bool has_src;
+  SDL_FRect src;
+  SDL_FRect dst;
+  double angle;
+  SDL_FPoint center;
+  S2D_Color color;
+} S2D_DrawCommand;
+
+// A draw of the last frame, to find what changed
+typedef struct {
+  SDL_Rect bounds;
+  uint64_t signature;
+} S2D_DrawRecord;
+
+static bool enabled = false;
+static bool recording = false;  // during `S2D_Render()`
+static bool full_redraw = true;
+
+// This frame's draws, and the last frame's
+static S2D_DrawCommand *commands = NULL;
+static int command_count = 0;
+static int command_capacity = 0;
+static S2D_DrawRecord *previous = NULL;
+static int previous_count = 0;
+static int previous_capacity = 0;
+
+// Damaged regions of the back buffer, which never overlap
+static SDL_Rect damage[S2D_DIRTY_MAX_RECTS];
+static int damage_count = 0;
+
+// Keeps the last frame's pixels, since the window's are undefined after presenting
+// at the frame's target resolution, replaying draws at its render scale
+static SDL_Texture *back_buffer = NULL;
+static SDL_Rect screen = { 0, 0, 0, 0 };  // in renderer coordinates
+static float render_scale = 1;
+static int pad = 1;  // renderer coordinates covering a target pixel
+static S2D_Color background;
+
+static S2D_DirtyRectStats stats;
+
+
+/*
+ * Enable or disable dirty rectangle mode, where the window is kept in a back
+ * buffer and only regions changed since the last frame are drawn again
+ */
+void S2D_EnableDirtyRects(bool status) {
+  enabled = status;
+  full_redraw = true;
+  previous_count = 0;
+  if (!enabled && back_buffer) {
+    SDL_DestroyTexture(back_buffer);
+    back_buffer = NULL;
+  }
+}
+
+
+/*
+ * Redraw the whole window on the next frame, like when render targets were
+ * reset. If the back buffer was lost with the renderer's device, it's recreated.
+ */
+void S2D_InvalidateDirtyRects(bool textures_lost) {
+  full_redraw = true;
+  if (textures_lost && back_buffer) {
+    SDL_DestroyTexture(back_buffer);
+    back_buffer = NULL;
+  }
+}
+
+
+/*
+ * Get the area of a rectangle
+ */
+static Sint64 area(const SDL_Rect *r) {
+  return (Sint64)r->w * r->h;
+}
+
+
+/*
+ * Add a region of renderer coordinates to be drawn again, merging it with those it
+ * overlaps, or with the one growing least when out of regions
+ */
+static void add_damage(SDL_Rect r) {
+  if (!SDL_GetRectIntersection(&r, &screen, &r)) return;
+
+  for (int i = 0; i < damage_count; i++) {
+    if (SDL_HasRectIntersection(&r, &damage[i])) {
+      SDL_GetRectUnion(&r, &damage[i], &r);
+      damage[i] = damage[--damage_count];
+      i = -1;  // the union may overlap regions already checked
+    }
+  }
+
+  if (damage_count == S2D_DIRTY_MAX_RECTS) {
+    int best = 0;
+    Sint64 best_growth = -1;
+    for (int i = 0; i < damage_count; i++) {
+      SDL_Rect u;
+      SDL_GetRectUnion(&r, &damage[i], &u);
+      Sint64 growth = area(&u) - area(&damage[i]);
+      if (best_growth < 0 || growth < best_growth) {
+        best = i;
+        best_growth = growth;
+      }
+    }
+    SDL_GetRectUnion(&r, &damage[best], &r);
+    damage[best] = damage[--damage_count];
+    add_damage(r);
+    return;
+  }
+
+  damage[damage_count++] = r;
+}
+
+
+/*
+ * Mark a region of the window, in window coordinates, to be drawn again in
+ * dirty rectangle mode, like for content drawn directly with SDL
+ */
+void S2D_AddDamage(float x, float y, float width, float height) {
+  if (!enabled) return;
+  SDL_FRect rect = { x, y, width, height };
+  S2D_WindowToRendererCoordinatesRect(&rect);
+  add_damage((SDL_Rect) {
+    (int) floorf(rect.x), (int) floorf(rect.y), (int) ceilf(rect.w) + 1, (int) ceilf(rect.h) + 1
+  });
+}
+
+
+/*
+ * Hash bytes using 64-bit FNV-1a, continuing from a previous hash
+ */
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *) data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+
+/*
+ * Get the renderer coordinates covered by points, padded by a target pixel for
+ * edges blended with their neighbors
+ */
+static SDL_Rect bounds_of(const SDL_FPoint *points, int count, size_t stride) {
+  const char *p = (const char *) points;
+  float min_x = points->x, min_y = points->y, max_x = points->x, max_y = points->y;
+  for (int i = 1; i < count; i++) {
+    const SDL_FPoint *point = (const SDL_FPoint *)(p + i * stride);
+    if (point->x < min_x) min_x = point->x;
+    if (point->y < min_y) min_y = point->y;
+    if (point->x > max_x) max_x = point->x;
+    if (point->y > max_y) max_y = point->y;
+  }
+  int x = (int) floorf(min_x) - pad;
+  int y = (int) floorf(min_y) - pad;
+  return (SDL_Rect) { x, y, (int) ceilf(max_x) + pad - x, (int) ceilf(max_y) + pad - y };
+}
+
+
+/*
+ * Add a command to this frame's draws, growing the list as needed
+ */
+static S2D_DrawCommand *add_command() {
+  if (command_count == command_capacity) {
+    int capacity = command_capacity ? command_capacity * 2 : 256;
+    S2D_DrawCommand *list = (S2D_DrawCommand *) realloc(commands, capacity * sizeof(S2D_DrawCommand));
+    if (!list) {
+      S2D_Error("S2D_EndDirtyFrame", "Out of memory!");
+      return NULL;
+    }
+    commands = list;
+    command_capacity = capacity;
+  }
+  return &commands[command_count++];
+}
+
+
+/*
+ * Returns true if draws should be recorded instead of drawn, which they are
+ * in dirty rectangle mode unless drawing into a layer
+ */
+static bool recording_draws() {
+  return recording && SDL_GetRenderTarget(s2d_app.window->sdl_renderer) == S2D_GetViewportTarget();
+}
+
+
+/*
+ * Draw triangles, given vertices in renderer coordinates and optional
+ * indices, or record them in dirty rectangle mode
+ */
+void S2D_RenderGeometry(const SDL_Vertex *vertices, int count, const int *indices, int index_count) {
+  if (count < 1) return;
+  if (!recording_draws()) {
+    SDL_RenderGeometry(s2d_app.window->sdl_renderer, NULL, vertices, count, indices, index_count);
+    return;
+  }
+
+  // Copy the vertices, which may be on the caller's stack
+  SDL_Vertex *v = (SDL_Vertex *) S2D_FrameAlloc(count * sizeof(SDL_Vertex));
+  int *i = index_count > 0 ? (int *) S2D_FrameAlloc(index_count * sizeof(int)) : NULL;
+  if (!v || (index_count > 0 && !i)) return;
+  memcpy(v, vertices, count * sizeof(SDL_Vertex));
+  if (i) memcpy(i, indices, index_count * sizeof(int));
+
+  S2D_DrawCommand *cmd = add_command();
+  if (!cmd) return;
+  memset(cmd, 0, sizeof(S2D_DrawCommand));
+  cmd->vertices = v;
+  cmd->vertex_count = count;
+  cmd->indices = i;
+  cmd->index_count = i ? index_count : 0;
+  cmd->bounds = bounds_of(&v->position, count, sizeof(SDL_Vertex));
+  cmd->signature = hash_bytes(14695981039346656037ull, v, count * sizeof(SDL_Vertex));
+  if (i) cmd->signature = hash_bytes(cmd->signature, i, index_count * sizeof(int));
+}
+
+
+/*
+ * Draw a texture, given renderer rectangles, the rotation in degrees around
+ * `center` (relative to `dst`, or NULL for its center), and a color filter,
+ * or record it in dirty rectangle mode. The content, like a text message,
+ * tells apart different pixels in a reused texture.
+ */
+void S2D_RenderTexture(SDL_Texture *texture, const void *content, size_t content_size,
+                       const SDL_FRect *src, const SDL_FRect *dst,
+                       double angle, const SDL_FPoint *center, S2D_Color color) {
+  if (!recording_draws()) {
+    SDL_SetTextureColorModFloat(texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaModFloat(texture, color.a);
+    SDL_RenderTextureRotated(s2d_app.window->sdl_renderer, texture, src, dst, angle, center, SDL_FLIP_NONE);
+    return;
+  }
+
+  S2D_DrawCommand *cmd = add_command();
+  if (!cmd) return;
+  memset(cmd, 0, sizeof(S2D_DrawCommand));
+  cmd->texture = texture;
+  cmd->has_src = src != NULL;
+  if (src) cmd->src = *src;
+  cmd->dst = *dst;
+  cmd->angle = angle;
+  cmd->center = center ? *center : (SDL_FPoint) { dst->w / 2, dst->h / 2 };
+  cmd->color = color;
+
+  // Find the rotated corners' bounds
+  SDL_FPoint corners[4] = {
+    { dst->x, dst->y }, { dst->x + dst->w, dst->y },
+    { dst->x + dst->w, dst->y + dst->h }, { dst->x, dst->y + dst->h }
+  };
+  if (angle != 0) {
+    float rx = dst->x + cmd->center.x, ry = dst->y + cmd->center.y;
+    for (int i = 0; i < 4; i++) {
+      S2D_Point p = S2D_RotatePoint((S2D_Point) { corners[i].x, corners[i].y }, angle, rx, ry);
+      corners[i] = (SDL_FPoint) { p.x, p.y };
+    }
+  }
+  cmd->bounds = bounds_of(corners, 4, sizeof(SDL_FPoint));
+
+  uint64_t hash = hash_bytes(14695981039346656037ull, &texture, sizeof(texture));
+  if (content) hash = hash_bytes(hash, content, content_size);
+  if (src) hash = hash_bytes(hash, src, sizeof(SDL_FRect));
+  hash = hash_bytes(hash, dst, sizeof(SDL_FRect));
+  hash = hash_bytes(hash, &angle, sizeof(angle));
+  hash = hash_bytes(hash, &cmd->center, sizeof(SDL_FPoint));
+  cmd->signature = hash_bytes(hash, &color, sizeof(S2D_Color));
+}
+
+
+/*
+ * Draw a recorded command
+ */
+static void replay(const S2D_DrawCommand *cmd) {
+  SDL_Renderer *renderer = s2d_app.window->sdl_renderer;
+  if (!cmd->texture) {
+    SDL_RenderGeometry(renderer, NULL, cmd->vertices, cmd->vertex_count, cmd->indices, cmd->index_count);
+    return;
+  }
+  SDL_SetTextureColorModFloat(cmd->texture, cmd->color.r, cmd->color.g, cmd->color.b);
+  SDL_SetTextureAlphaModFloat(cmd->texture, cmd->color.a);
+  SDL_RenderTextureRotated(
+    renderer, cmd->texture, cmd->has_src ? &cmd->src : NULL, &cmd->dst, cmd->angle, &cmd->center, SDL_FLIP_NONE
+  );
+}
+
+
+/*
+ * Begin a frame in dirty rectangle mode, sizing the back buffer to the frame's
+ * target, so a viewport drawn at a lower internal resolution fills fewer
+ * pixels. Returns false if not enabled, so the frame is drawn as usual.
+ */
+bool S2D_BeginDirtyFrame() {
+  SDL_Renderer *renderer = s2d_app.window->sdl_renderer;
+  if (!enabled || !renderer) return false;
+
+  int frame_w, frame_h;
+  S2D_GetFrameSize(&frame_w, &frame_h);
+  SDL_Texture *target = S2D_GetViewportTarget();
+  int w = target ? target->w : frame_w;
+  int h = target ? target->h : frame_h;
+  if (w < 1 || h < 1 || frame_w < 1 || frame_h < 1) return false;
+
+  // Create the back buffer, or create it again at the window's new size
+  if (!back_buffer || back_buffer->w != w || back_buffer->h != h) {
+    if (back_buffer) SDL_DestroyTexture(back_buffer);
+    back_buffer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (!back_buffer) {
+      S2D_Error("SDL_CreateTexture", SDL_GetError());
+      return false;
+    }
+    SDL_SetTextureBlendMode(back_buffer, SDL_BLENDMODE_NONE);
+    full_redraw = true;
+  }
+  screen = (SDL_Rect) { 0, 0, frame_w, frame_h };
+  render_scale = S2D_GetViewportRenderScale();
+  pad = render_scale < 1 ? (int) ceilf(1 / render_scale) : 1;
+
+  S2D_Color bg = s2d_app.window->background;
+  if (memcmp(&bg, &background, sizeof(S2D_Color)) != 0) full_redraw = true;
+  background = bg;
+
+  command_count = 0;
+  recording = true;
+  return true;
+}
+
+
+/*
+ * End a frame in dirty rectangle mode, drawing again the regions where this
+ * frame's draws differ from the last frame's, then copying the back buffer
+ * to the frame (the window, or the viewport's target when scaling)
+ */
+void S2D_EndDirtyFrame() {
+  if (!recording) return;
+  recording = false;
+  SDL_Renderer *renderer = s2d_app.window->sdl_renderer;
+
+  // Damage the old and new bounds of draws that changed, were added, or were
+  // removed, comparing draws in order
+  if (!full_redraw) {
+    int count = command_count > previous_count ? command_count : previous_count;
+    for (int i = 0; i < count; i++) {
+      const S2D_DrawCommand *cmd = i < command_count ? &commands[i] : NULL;
+      const S2D_DrawRecord *prev = i < previous_count ? &previous[i] : NULL;
+      if (cmd && prev && cmd->signature == prev->signature) continue;
+      if (cmd) add_damage(cmd->bounds);
+      if (prev) add_damage(prev->bounds);
+    }
+  }
+
+  // Draw everything if most of the window changed
+  Sint64 damaged = 0;
+  for (int i = 0; i < damage_count; i++) damaged += area(&damage[i]);
+  if (full_redraw || damaged > area(&screen) * S2D_DIRTY_FULL_REDRAW) {
+    damage[0] = screen;
+    damage_count = 1;
+    damaged = area(&screen);
+    stats.full_redraws++;
+  }
+
+  // Clear each region to the background and draw what overlaps it, at the
+  // target's render scale. The clip rectangle is rounded out to whole pixels,
+  // so clear all of it, and draws' bounds are padded to cover those pixels.
+  int replayed = 0;
+  SDL_SetRenderTarget(renderer, back_buffer);
+  SDL_SetRenderScale(renderer, render_scale, render_scale);
+  for (int r = 0; r < damage_count; r++) {
+    SDL_SetRenderClipRect(renderer, &damage[r]);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColorFloat(renderer, background.r, background.g, background.b, background.a);
+    SDL_RenderFillRect(renderer, NULL);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    for (int i = 0; i < command_count; i++) {
+      if (!SDL_HasRectIntersection(&commands[i].bounds, &damage[r])) continue;
+      replay(&commands[i]);
+      replayed++;
+    }
+  }
+  SDL_SetRenderClipRect(renderer, NULL);
+  SDL_SetRenderTarget(renderer, S2D_GetViewportTarget());
+  SDL_FRect frame = { 0, 0, back_buffer->w / render_scale, back_buffer->h / render_scale };
+  SDL_RenderTexture(renderer, back_buffer, NULL, &frame);
+
+  stats.frames++;
+  if (damage_count == 0) stats.idle_frames++;
+  stats.commands = command_count;
+  stats.replayed = replayed;
+  stats.rects = damage_count;
+  stats.damaged = screen.w > 0 && screen.h > 0 ? (float)((double) damaged / area(&screen)) : 0;
+
+  // Keep what's needed of this frame's draws to compare with the next
+  if (command_count > previous_capacity) {
+    S2D_DrawRecord *list = (S2D_DrawRecord *) realloc(previous, command_count * sizeof(S2D_DrawRecord));
+    if (!list) {
+      S2D_Error("S2D_EndDirtyFrame", "Out of memory!");
+      previous_count = 0;
+      full_redraw = true;
+      damage_count = 0;
+      return;
+    }
+    previous = list;
+    previous_capacity = command_count;
+  }
+  for (int i = 0; i < command_count; i++) {
+    previous[i].bounds = commands[i].bounds;
+    previous[i].signature = commands[i].signature;
+  }
+  previous_count = command_count;
+  damage_count = 0;
+  full_redraw = false;
+}
+
+
+/*
+ * Get statistics for dirty rectangle mode
+ */
+void S2D_GetDirtyRectStats(S2D_DirtyRectStats *out) {
+  if (out) *out = stats;
+}
+
+
+/*
+ * Free the back buffer and draw lists when quitting
+ */
+void S2D_FreeDirtyRects() {
+  if (back_buffer) SDL_DestroyTexture(back_buffer);
+  back_buffer = NULL;
+  free(commands);
+  commands = NULL;
+  command_count = command_capacity = 0;
+  free(previous);
+  previous = NULL;
+  previous_count = previous_capacity = 0;
+}
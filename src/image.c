@@ -2,35 +2,87 @@
 
 #include "../include/simple2d.h"
 
+// Pool of image structures
+static S2D_Pool image_pool = S2D_POOL(S2D_Image, "image", 256);
+
+// Live images, for memory accounting
+static S2D_Image **image_list = NULL;
+static int image_count = 0;
+static int image_capacity = 0;
+
 
 /*
- * Create an image, given a file path
+ * Add an image to the list of live images
  */
-S2D_Image *S2D_CreateImage(const char *path) {
+static bool track_image(S2D_Image *img) {
+  if (image_count == image_capacity) {
+    int capacity = image_capacity ? image_capacity * 2 : 64;
+    S2D_Image **list = (S2D_Image **) realloc(image_list, capacity * sizeof(S2D_Image *));
+    if (!list) return false;
+    image_list = list;
+    image_capacity = capacity;
+  }
+  img->live_index = image_count;
+  image_list[image_count++] = img;
+  return true;
+}
 
-  // Check if image file exists
-  if (!S2D_FileExists(path)) {
-    S2D_Error("S2D_CreateImage", "Image file `%s` not found", path);
-    return NULL;
+
+/*
+ * Remove an image from the list of live images, in constant time
+ */
+static void untrack_image(S2D_Image *img) {
+  S2D_Image *last = image_list[--image_count];
+  image_list[img->live_index] = last;
+  last->live_index = img->live_index;
+}
+
+
+/*
+ * Get the list of live images
+ */
+S2D_Image *const *S2D_GetLiveImages(int *count) {
+  if (count) *count = image_count;
+  return image_list;
+}
+
+
+/*
+ * Load an image from a file path, decoding it or using the texture cache
+ */
+static S2D_Image *create_image(const char *path) {
+
+  // Use the decoded pixels from the texture cache, if enabled and current
+  SDL_Surface *surface = S2D_LoadCachedSurface(path);
+
+  if (!surface) {
+    // Open the image from a mounted pack or the file system
+    SDL_IOStream *io = S2D_OpenAsset(path);
+    if (!io) {
+      S2D_Error("S2D_CreateImage", "Image file `%s` not found", path);
+      return NULL;
+    }
+
+    // Decode the image as SDL_Surface
+    surface = IMG_Load_IO(io, true);
+    if (!surface) {
+      S2D_Error("IMG_Load", SDL_GetError());
+      return NULL;
+    }
+    surface = S2D_StoreCachedSurface(path, surface);
   }
 
   // Allocate the image structure
-  S2D_Image *img = (S2D_Image *) malloc(sizeof(S2D_Image));
+  S2D_Image *img = (S2D_Image *) S2D_PoolAlloc(&image_pool);
   if (!img) {
     S2D_Error("S2D_CreateImage", "Out of memory!");
+    SDL_DestroySurface(surface);
     return NULL;
   }
-
-  // Load image from file as SDL_Surface
-  img->surface = IMG_Load(path);
-  if (!img->surface) {
-    S2D_Error("IMG_Load", SDL_GetError());
-    free(img);
-    return NULL;
-  }
+  img->surface = surface;
 
   // Initialize values
-  img->path = strdup(path);
+  img->path = S2D_InternString(path);
   img->texture = NULL;
   img->x = 0;
   img->y = 0;
@@ -50,11 +102,30 @@ S2D_Image *S2D_CreateImage(const char *path) {
   img->rotate = 0.0;
   img->rx = 0.0;
   img->ry = 0.0;
+  img->live_index = -1;
 
   return img;
 }
 
 
+/*
+ * Create an image, given a file path
+ */
+S2D_Image *S2D_CreateImage(const char *path) {
+  Uint64 phase = S2D_BeginStartupPhase();
+  S2D_TraceBeginDetail("S2D_CreateImage", path);
+  S2D_Image *img = create_image(path);
+  if (img && !track_image(img)) {
+    S2D_Error("S2D_CreateImage", "Out of memory!");
+    S2D_FreeImage(img);
+    img = NULL;
+  }
+  S2D_TraceEnd();
+  S2D_EndStartupPhase(phase, "S2D_CreateImage(\"%s\")", path);
+  return img;
+}
+
+
 /*
  * Rotate an image
  */
@@ -109,23 +180,23 @@ void S2D_UnclipImage(S2D_Image *img) {
 }
 
 
+/*
+ * Upload an image's texture ahead of its first draw, ignoring the upload budget.
+ * Returns false if the window isn't shown yet, since there's no renderer.
+ */
+bool S2D_PreloadImage(S2D_Image *img) {
+  if (!img || !s2d_app.window->sdl_renderer) return false;
+  if (!img->texture) img->texture = S2D_UploadSurface(&img->surface, false);
+  return img->texture != NULL;
+}
+
+
 /*
  * Draw an image
  */
 void S2D_DrawImage(S2D_Image *img) {
   if (!img) return;
 
-  if (img->texture == NULL) {
-    img->texture = SDL_CreateTextureFromSurface(s2d_app.window->sdl_renderer, img->surface);
-    if (!img->texture) {
-      S2D_Error("SDL_CreateTextureFromSurface", SDL_GetError());
-      return;
-    }
-    SDL_SetTextureBlendMode(img->texture, SDL_BLENDMODE_BLEND);
-    SDL_DestroySurface(img->surface);
-    img->surface = NULL;
-  }
-
   SDL_FRect dst_rect = {
     img->x,
     img->y,
@@ -153,16 +224,23 @@ void S2D_DrawImage(S2D_Image *img) {
   }
 
   S2D_WindowToRendererCoordinatesRect(&dst_rect);
-  SDL_SetTextureColorModFloat(img->texture, img->color.r, img->color.g, img->color.b);
-  SDL_SetTextureAlphaModFloat(img->texture, img->color.a);
+
+  // Upload the texture on first draw, within the frame's upload budget
+  if (img->texture == NULL) {
+    img->texture = S2D_UploadSurface(&img->surface, true);
+    if (!img->texture) {
+      if (img->surface) S2D_DrawUploadPlaceholder(&dst_rect);
+      return;
+    }
+  }
 
   float scale = s2d_app.window->display_scale;
   SDL_FPoint center = {
     (img->rx - img->x) * scale,
     (img->ry - img->y) * scale
   };
-  SDL_RenderTextureRotated(
-    s2d_app.window->sdl_renderer, img->texture, src_rect, &dst_rect, img->rotate, &center, SDL_FLIP_NONE
+  S2D_RenderTexture(
+    img->texture, &img->path, sizeof(img->path), src_rect, &dst_rect, img->rotate, &center, img->color
   );
 }
 
@@ -172,8 +250,9 @@ void S2D_DrawImage(S2D_Image *img) {
  */
 void S2D_FreeImage(S2D_Image *img) {
   if (!img) return;
-  free((void*)img->path);
+  if (img->live_index >= 0) untrack_image(img);
+  S2D_ReleaseString(img->path);
   if (img->surface) SDL_DestroySurface(img->surface);
   if (img->texture) SDL_DestroyTexture(img->texture);
-  free(img);
+  S2D_PoolFree(&image_pool, img);
 }
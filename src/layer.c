@@ -0,0 +1,218 @@
+// layer.c
+
+#include "../include/simple2d.h"
+
+// Live layers, invalidated together when the window or renderer changes
+static S2D_Layer **layer_list = NULL;
+static int layer_count = 0;
+static int layer_capacity = 0;
+
+
+/*
+ * Add a layer to the list of live layers
+ */
+static bool track_layer(S2D_Layer *layer) {
+  if (layer_count == layer_capacity) {
+    int capacity = layer_capacity ? layer_capacity * 2 : 16;
+    S2D_Layer **list = (S2D_Layer **) realloc(layer_list, capacity * sizeof(S2D_Layer *));
+    if (!list) return false;
+    layer_list = list;
+    layer_capacity = capacity;
+  }
+  layer->live_index = layer_count;
+  layer_list[layer_count++] = layer;
+  return true;
+}
+
+
+/*
+ * Remove a layer from the list of live layers, in constant time
+ */
+static void untrack_layer(S2D_Layer *layer) {
+  S2D_Layer *last = layer_list[--layer_count];
+  layer_list[layer->live_index] = last;
+  last->live_index = layer->live_index;
+}
+
+
+/*
+ * Get the list of live layers
+ */
+S2D_Layer *const *S2D_GetLiveLayers(int *count) {
+  if (count) *count = layer_count;
+  return layer_list;
+}
+
+
+/*
+ * Create a layer, given its size in window coordinates, or 0 to follow the
+ * viewport's size. Its content is drawn between `S2D_BeginLayer()` and
+ * `S2D_EndLayer()` only when dirty, and composited with `S2D_DrawLayer()`.
+ */
+S2D_Layer *S2D_CreateLayer(int width, int height) {
+  S2D_Layer *layer = (S2D_Layer *) calloc(1, sizeof(S2D_Layer));
+  if (!layer || !track_layer(layer)) {
+    S2D_Error("S2D_CreateLayer", "Out of memory!");
+    free(layer);
+    return NULL;
+  }
+
+  layer->fit_window = width <= 0 || height <= 0;
+  layer->width  = layer->fit_window ? s2d_app.window->viewport.width  : width;
+  layer->height = layer->fit_window ? s2d_app.window->viewport.height : height;
+  layer->color.r = 1.f;
+  layer->color.g = 1.f;
+  layer->color.b = 1.f;
+  layer->color.a = 1.f;
+  layer->dirty = true;
+
+  return layer;
+}
+
+
+/*
+ * Create or resize a layer's render target texture to its size in renderer
+ * pixels, at the current display scale
+ */
+static bool size_texture(S2D_Layer *layer) {
+  if (layer->fit_window) {
+    layer->width  = s2d_app.window->viewport.width;
+    layer->height = s2d_app.window->viewport.height;
+  }
+
+  float scale = s2d_app.window->display_scale;
+  int w = (int) SDL_ceilf(layer->width * scale);
+  int h = (int) SDL_ceilf(layer->height * scale);
+  if (w < 1) w = 1;
+  if (h < 1) h = 1;
+  if (layer->texture && layer->texture->w == w && layer->texture->h == h) return true;
+
+  if (layer->texture) SDL_DestroyTexture(layer->texture);
+  layer->texture = SDL_CreateTexture(
+    s2d_app.window->sdl_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, w, h
+  );
+  if (!layer->texture) {
+    S2D_Error("SDL_CreateTexture", SDL_GetError());
+    return false;
+  }
+
+  // Drawing with blending onto a transparent target leaves premultiplied
+  // colors, so composite them as such
+  SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+  layer->scale = scale;
+  layer->dirty = true;
+  return true;
+}
+
+
+/*
+ * Begin drawing a layer's content, if it's dirty or its size or the display
+ * scale changed. Returns true if the content should be drawn, followed by
+ * `S2D_EndLayer()`; when false, the cached content is still current.
+ */
+bool S2D_BeginLayer(S2D_Layer *layer) {
+  if (!layer || !s2d_app.window->sdl_renderer) return false;
+  if (!size_texture(layer) || !layer->dirty) return false;
+
+  SDL_Renderer *renderer = s2d_app.window->sdl_renderer;
+  layer->prev_target = SDL_GetRenderTarget(renderer);
+  if (!SDL_SetRenderTarget(renderer, layer->texture)) {
+    S2D_Error("SDL_SetRenderTarget", SDL_GetError());
+    return false;
+  }
+
+  // Remember deferred uploads, so placeholders aren't cached as content
+  S2D_UploadStats uploads;
+  S2D_GetUploadStats(&uploads);
+  layer->deferred = uploads.deferred;
+
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+  SDL_RenderClear(renderer);
+  S2D_TraceBegin("Layer redraw");
+  return true;
+}
+
+
+/*
+ * End drawing a layer's content, restoring the previous render target. The
+ * layer stays dirty if a texture's upload was deferred while drawing.
+ */
+void S2D_EndLayer(S2D_Layer *layer) {
+  if (!layer) return;
+  S2D_TraceEnd();
+  SDL_SetRenderTarget(s2d_app.window->sdl_renderer, layer->prev_target);
+  layer->prev_target = NULL;
+
+  S2D_UploadStats uploads;
+  S2D_GetUploadStats(&uploads);
+  layer->dirty = uploads.deferred != layer->deferred;
+  layer->redraws++;
+}
+
+
+/*
+ * Mark a layer's content as changed, to be drawn again
+ */
+void S2D_InvalidateLayer(S2D_Layer *layer) {
+  if (layer) layer->dirty = true;
+}
+
+
+/*
+ * Mark every layer's content as changed, like when render targets were reset.
+ * If the textures were lost with the renderer's device, they're recreated.
+ */
+void S2D_InvalidateLayers(bool textures_lost) {
+  for (int i = 0; i < layer_count; i++) {
+    S2D_Layer *layer = layer_list[i];
+    if (textures_lost && layer->texture) {
+      SDL_DestroyTexture(layer->texture);
+      layer->texture = NULL;
+    }
+    layer->dirty = true;
+  }
+}
+
+
+/*
+ * Draw a layer's cached content at its position, tinted by its color
+ */
+void S2D_DrawLayer(S2D_Layer *layer) {
+  if (!layer || !layer->texture) return;
+
+  SDL_FRect dst_rect = {
+    layer->x,
+    layer->y,
+    layer->texture->w / layer->scale,
+    layer->texture->h / layer->scale
+  };
+  S2D_WindowToRendererCoordinatesRect(&dst_rect);
+
+  // Colors are premultiplied, so fade them along with alpha
+  S2D_Color color = {
+    layer->color.r * layer->color.a, layer->color.g * layer->color.a, layer->color.b * layer->color.a, layer->color.a
+  };
+  S2D_RenderTexture(layer->texture, &layer->redraws, sizeof(layer->redraws), NULL, &dst_rect, 0, NULL, color);
+}
+
+
+/*
+ * Free a layer
+ */
+void S2D_FreeLayer(S2D_Layer *layer) {
+  if (!layer) return;
+  if (layer->live_index >= 0) untrack_layer(layer);
+  if (layer->texture) SDL_DestroyTexture(layer->texture);
+  free(layer);
+}
+
+
+/*
+ * Free layers left when quitting, before the renderer is destroyed
+ */
+void S2D_FreeLayers() {
+  while (layer_count > 0) S2D_FreeLayer(layer_list[layer_count - 1]);
+  free(layer_list);
+  layer_list = NULL;
+  layer_capacity = 0;
+}
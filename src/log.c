@@ -0,0 +1,421 @@
+// log.c
+
+#include "../include/simple2d.h"
+
+// A queued message, in a slot of the ring buffer
+typedef struct {
+  SDL_AtomicInt seq;  // ready to write when equal to the write position, to read when one past
+  int type;
+  Uint64 time;        // nanoseconds since SDL was initialized
+  char msg[S2D_LOG_MESSAGE_SIZE];
+} S2D_LogEntry;
+
+// A call site's messages in the current one-second window, for rate limiting
+typedef struct {
+  SDL_AtomicInt key;         // hash of the call site, or 0 if unused
+  SDL_AtomicInt window;      // second the count applies to
+  SDL_AtomicInt count;
+  SDL_AtomicInt suppressed;  // messages dropped in the window
+} S2D_LogSite;
+
+#define LOG_SITES 64
+
+// The address a logging function returns to, identifying its call site
+#if defined(__GNUC__) || defined(__clang__)
+  #define CALLER_ADDRESS() ((uintptr_t) __builtin_return_address(0))
+#elif defined(_MSC_VER)
+  #include <intrin.h>
+  #define CALLER_ADDRESS() ((uintptr_t) _ReturnAddress())
+#else
+  #define CALLER_ADDRESS() ((uintptr_t) 0)
+#endif
+
+// Bounded multi-producer, single-consumer queue of messages
+static S2D_LogEntry queue[S2D_LOG_QUEUE_SIZE];
+static SDL_AtomicInt write_pos;  // claimed by producers
+static int read_pos = 0;         // only touched by the logging thread
+static SDL_AtomicInt written;    // messages written out, for flushing
+static SDL_AtomicInt dropped;    // messages dropped while the queue was full, since noted
+static SDL_AtomicInt total_dropped;
+static SDL_AtomicInt suppressed; // messages dropped by rate limiting
+
+static S2D_LogSite sites[LOG_SITES];
+
+static SDL_Thread *log_thread = NULL;
+static SDL_Semaphore *log_signal = NULL;
+static SDL_AtomicInt running;
+
+// Output settings
+static int log_level = S2D_INFO;
+static int rate_limit = 0;  // messages per call site per second, 0 is unlimited
+static FILE *log_file = NULL;
+static SDL_Mutex *file_lock = NULL;
+
+
+/*
+ * Write a message to the console, and the log file if set
+ */
+static void write_message(int type, Uint64 time, const char *msg) {
+  const char *label = "";
+  switch (type) {
+    case S2D_INFO:
+      label = "\033[1;36mInfo:\033[0m ";
+      break;
+    case S2D_WARN:
+      label = "\033[1;33mWarning:\033[0m ";
+      break;
+    case S2D_ERROR:
+      label = "\033[1;31mError:\033[0m ";
+      break;
+  }
+
+  double seconds = time / 1e9;
+  printf("[%9.3f] %s%s\n", seconds, label, msg);
+
+  if (file_lock) SDL_LockMutex(file_lock);
+  if (log_file) {
+    const char *plain = type == S2D_ERROR ? "Error" : type == S2D_WARN ? "Warning" : "Info";
+    fprintf(log_file, "[%9.3f] %s: %s\n", seconds, plain, msg);
+  }
+  if (file_lock) SDL_UnlockMutex(file_lock);
+}
+
+
+/*
+ * Claim a slot in the queue and copy a message into it. Returns false if the
+ * queue is full.
+ */
+static bool push_message(int type, Uint64 time, const char *msg) {
+  Uint32 pos = (Uint32) SDL_GetAtomicInt(&write_pos);
+  S2D_LogEntry *entry;
+
+  for (;;) {
+    entry = &queue[pos % S2D_LOG_QUEUE_SIZE];
+    Sint32 diff = (Sint32)((Uint32) SDL_GetAtomicInt(&entry->seq) - pos);
+    if (diff == 0) {
+      if (SDL_CompareAndSwapAtomicInt(&write_pos, (int) pos, (int)(pos + 1))) break;
+    } else if (diff < 0) {
+      return false;  // the logging thread hasn't read this slot yet
+    }
+    pos = (Uint32) SDL_GetAtomicInt(&write_pos);
+  }
+
+  entry->type = type;
+  entry->time = time;
+  SDL_strlcpy(entry->msg, msg, sizeof(entry->msg));
+  SDL_SetAtomicInt(&entry->seq, (int)(pos + 1));  // publish to the logging thread
+  return true;
+}
+
+
+/*
+ * Write queued messages until the queue is empty
+ */
+static void drain_queue() {
+  for (;;) {
+    S2D_LogEntry *entry = &queue[read_pos % S2D_LOG_QUEUE_SIZE];
+    if ((Uint32) SDL_GetAtomicInt(&entry->seq) != (Uint32) read_pos + 1) break;
+
+    write_message(entry->type, entry->time, entry->msg);
+    SDL_SetAtomicInt(&entry->seq, (int)((Uint32) read_pos + S2D_LOG_QUEUE_SIZE));  // free the slot
+    read_pos++;
+    SDL_AddAtomicInt(&written, 1);
+  }
+
+  // Report messages lost to a full queue since the last report
+  int lost = SDL_SetAtomicInt(&dropped, 0);
+  if (lost > 0) {
+    char note[64];
+    snprintf(note, sizeof(note), "%d log messages dropped, queue full", lost);
+    write_message(S2D_WARN, SDL_GetTicksNS(), note);
+  }
+
+  fflush(stdout);
+  if (file_lock) SDL_LockMutex(file_lock);
+  if (log_file) fflush(log_file);
+  if (file_lock) SDL_UnlockMutex(file_lock);
+}
+
+
+/*
+ * Write messages as they're queued, until stopped
+ */
+static int SDLCALL run_log_thread(void *data) {
+  while (SDL_GetAtomicInt(&running)) {
+    SDL_WaitSemaphoreTimeout(log_signal, 100);
+    drain_queue();
+  }
+  drain_queue();
+  return 0;
+}
+
+
+/*
+ * Check a call site against the rate limit, returning false if the message
+ * should be dropped. When a new second starts, notes how many were dropped.
+ */
+static bool within_rate_limit(uintptr_t site, Uint64 time) {
+  if (rate_limit <= 0) return true;
+
+  // Hash the call site, reserving 0 for unused entries
+  int key = (int)((site * 2654435761u) >> 4) | 1;
+  S2D_LogSite *s = NULL;
+  for (int i = 0; i < LOG_SITES; i++) {
+    S2D_LogSite *probe = &sites[((unsigned) key + i) % LOG_SITES];
+    int probe_key = SDL_GetAtomicInt(&probe->key);
+    if (probe_key == key ||
+        (probe_key == 0 && (SDL_CompareAndSwapAtomicInt(&probe->key, 0, key) ||
+                            SDL_GetAtomicInt(&probe->key) == key))) {
+      s = probe;
+      break;
+    }
+  }
+  if (!s) return true;  // too many call sites to track; never limit the rest
+
+  int second = (int)(time / 1000000000);
+  int window = SDL_GetAtomicInt(&s->window);
+  if (window != second && SDL_CompareAndSwapAtomicInt(&s->window, window, second)) {
+    SDL_SetAtomicInt(&s->count, 0);
+    int lost = SDL_SetAtomicInt(&s->suppressed, 0);
+    if (lost > 0) {
+      char note[64];
+      snprintf(note, sizeof(note), "(%d similar messages suppressed)", lost);
+      if (!log_thread || !push_message(S2D_WARN, time, note)) write_message(S2D_WARN, time, note);
+    }
+  }
+
+  if (SDL_AddAtomicInt(&s->count, 1) >= rate_limit) {
+    SDL_AddAtomicInt(&s->suppressed, 1);
+    SDL_AddAtomicInt(&suppressed, 1);
+    return false;
+  }
+  return true;
+}
+
+
+/*
+ * Log a formatted message from a call site, queuing it for the logging
+ * thread if running, or writing it directly otherwise
+ */
+static void log_message(int type, uintptr_t site, const char *prefix, const char *msg, va_list args) {
+  // Always log if diagnostics set, or if a warning or error message
+  if (!s2d_app.diagnostics && type == S2D_INFO) return;
+  if (type < log_level) return;
+
+  Uint64 time = SDL_GetTicksNS();
+  if (!within_rate_limit(site, time)) return;
+
+  // Format on the stack, so logging never allocates (long messages are truncated)
+  char fmsg[S2D_LOG_MESSAGE_SIZE];
+  int len = prefix ? snprintf(fmsg, sizeof(fmsg), "%s", prefix) : 0;
+  if (len < 0 || len >= (int) sizeof(fmsg)) len = 0;
+  vsnprintf(fmsg + len, sizeof(fmsg) - len, msg, args);
+
+  if (!log_thread) {
+    write_message(type, time, fmsg);
+    fflush(stdout);
+    return;
+  }
+
+  if (push_message(type, time, fmsg)) {
+    SDL_SignalSemaphore(log_signal);
+  } else {
+    SDL_AddAtomicInt(&dropped, 1);
+    SDL_AddAtomicInt(&total_dropped, 1);
+  }
+}
+
+
+/*
+ * Identify a call site by its file and line, for rate limiting
+ */
+static uintptr_t call_site(const char *file, int line) {
+  return (uintptr_t) file * 31 + (uintptr_t) line;
+}
+
+
+/*
+ * Identify a call site by the caller's code address, or by the format string
+ * if the compiler doesn't provide it, for rate limiting
+ */
+static uintptr_t caller_site(uintptr_t address, const char *msg) {
+  return address ? address : (uintptr_t) msg;
+}
+
+
+/*
+ * Logs standard messages to the console
+ */
+void S2D_Log(int type, const char *msg, ...) {
+  va_list args;
+  va_start(args, msg);
+  log_message(type, caller_site(CALLER_ADDRESS(), msg), NULL, msg, args);
+  va_end(args);
+}
+
+
+/*
+ * Logs Simple 2D errors to the console, with caller and message body
+ */
+void S2D_Error(const char *caller, const char *msg, ...) {
+  char prefix[128];
+  snprintf(prefix, sizeof(prefix), "(%s) ", caller);
+
+  va_list args;
+  va_start(args, msg);
+  log_message(S2D_ERROR, caller_site(CALLER_ADDRESS(), msg), prefix, msg, args);
+  va_end(args);
+}
+
+
+/*
+ * Logs standard messages to the console, from the given call site
+ */
+void S2D_LogAt(const char *file, int line, int type, const char *msg, ...) {
+  va_list args;
+  va_start(args, msg);
+  log_message(type, call_site(file, line), NULL, msg, args);
+  va_end(args);
+}
+
+
+/*
+ * Logs Simple 2D errors to the console, with caller and message body, from
+ * the given call site
+ */
+void S2D_ErrorAt(const char *file, int line, const char *caller, const char *msg, ...) {
+  char prefix[128];
+  snprintf(prefix, sizeof(prefix), "(%s) ", caller);
+
+  va_list args;
+  va_start(args, msg);
+  log_message(S2D_ERROR, call_site(file, line), prefix, msg, args);
+  va_end(args);
+}
+
+
+/*
+ * Set the least severe message type logged, one of `S2D_INFO`, `S2D_WARN`,
+ * or `S2D_ERROR` (info messages are also only logged in diagnostics mode)
+ */
+void S2D_SetLogLevel(int type) {
+  log_level = type;
+}
+
+
+/*
+ * Set the most messages logged from a single call site each second, where 0
+ * (the default) is unlimited. Messages over the limit are counted and noted
+ * once dropped.
+ */
+void S2D_SetLogRateLimit(int per_second) {
+  rate_limit = per_second > 0 ? per_second : 0;
+}
+
+
+/*
+ * Also write log messages to a file, without terminal colors, or stop writing
+ * to the file if the path is NULL
+ */
+bool S2D_SetLogFile(const char *path) {
+  FILE *file = NULL;
+  if (path) {
+    file = fopen(path, "a");
+    if (!file) {
+      S2D_Error("S2D_SetLogFile", "Could not open log file `%s`", path);
+      return false;
+    }
+  }
+
+  S2D_FlushLog();
+  if (file_lock) SDL_LockMutex(file_lock);
+  if (log_file) fclose(log_file);
+  log_file = file;
+  if (file_lock) SDL_UnlockMutex(file_lock);
+  return true;
+}
+
+
+/*
+ * Start the logging thread, after which messages are queued and written in
+ * the background, keeping slow console and file output off the calling thread
+ */
+bool S2D_StartLogThread() {
+  if (log_thread) return true;
+
+  for (Uint32 i = 0; i < S2D_LOG_QUEUE_SIZE; i++) SDL_SetAtomicInt(&queue[i].seq, (int) i);
+  SDL_SetAtomicInt(&write_pos, 0);
+  SDL_SetAtomicInt(&written, 0);
+  read_pos = 0;
+
+  file_lock = SDL_CreateMutex();
+  log_signal = SDL_CreateSemaphore(0);
+  SDL_SetAtomicInt(&running, 1);
+  log_thread = log_signal && file_lock ? SDL_CreateThread(run_log_thread, "S2D_Log", NULL) : NULL;
+  if (!log_thread) {
+    SDL_SetAtomicInt(&running, 0);
+    if (log_signal) SDL_DestroySemaphore(log_signal);
+    if (file_lock) SDL_DestroyMutex(file_lock);
+    log_signal = NULL;
+    file_lock = NULL;
+    S2D_Error("SDL_CreateThread", SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+
+/*
+ * Wait until every message queued so far has been written
+ */
+void S2D_FlushLog() {
+  if (!log_thread) {
+    fflush(stdout);
+    return;
+  }
+
+  int target = SDL_GetAtomicInt(&write_pos);
+  while (SDL_GetAtomicInt(&written) - target < 0) {
+    SDL_SignalSemaphore(log_signal);
+    SDL_DelayNS(50000);
+  }
+}
+
+
+/*
+ * Get the number of messages written in the background, and those dropped
+ * because the queue was full or by the rate limit
+ */
+void S2D_GetLogStats(S2D_LogStats *stats) {
+  if (!stats) return;
+  stats->written = SDL_GetAtomicInt(&written);
+  stats->dropped = SDL_GetAtomicInt(&total_dropped);
+  stats->suppressed = SDL_GetAtomicInt(&suppressed);
+}
+
+
+/*
+ * Stop the logging thread, writing any queued messages, and close the log file
+ */
+void S2D_StopLogThread() {
+  if (log_thread) {
+    SDL_SetAtomicInt(&running, 0);
+    SDL_SignalSemaphore(log_signal);
+    SDL_WaitThread(log_thread, NULL);
+    log_thread = NULL;
+    SDL_DestroySemaphore(log_signal);
+    log_signal = NULL;
+    SDL_DestroyMutex(file_lock);
+    file_lock = NULL;
+  }
+
+  int lost = SDL_GetAtomicInt(&suppressed);
+  if (lost > 0 && s2d_app.diagnostics) {
+    char note[64];
+    snprintf(note, sizeof(note), "%d log messages suppressed by the rate limit", lost);
+    write_message(S2D_INFO, SDL_GetTicksNS(), note);
+  }
+
+  if (log_file) fclose(log_file);
+  log_file = NULL;
+}
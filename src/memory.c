@@ -0,0 +1,160 @@
+// memory.c
+
+#include "../include/simple2d.h"
+
+// A resource, for listing the largest
+typedef struct {
+  const char *kind;
+  const char *path;
+  size_t bytes;
+} S2D_MemoryResource;
+
+
+/*
+ * Get the bytes of pixels held by a surface
+ */
+static size_t surface_bytes(SDL_Surface *surface) {
+  return surface ? (size_t)surface->pitch * surface->h : 0;
+}
+
+
+/*
+ * Estimate the bytes of GPU memory held by a texture, from its size and format
+ */
+static size_t texture_bytes(SDL_Texture *texture) {
+  return texture ? (size_t)texture->w * texture->h * SDL_BYTESPERPIXEL(texture->format) : 0;
+}
+
+
+/*
+ * Add a resource to a usage count, if it holds memory
+ */
+static void add_usage(S2D_MemoryUsage *usage, size_t bytes) {
+  if (bytes == 0) return;
+  usage->count++;
+  usage->bytes += bytes;
+}
+
+
+/*
+ * Get the memory used by live images, text, fonts, audio, and layers, and by
+ * Simple 2D's pools, interned strings, and frame arena. Texture sizes are
+ * estimates of GPU memory, from their size and pixel format.
+ */
+void S2D_GetMemoryStats(S2D_MemoryStats *stats) {
+  if (!stats) return;
+  memset(stats, 0, sizeof(S2D_MemoryStats));
+
+  int count;
+  S2D_Image *const *images = S2D_GetLiveImages(&count);
+  for (int i = 0; i < count; i++) {
+    add_usage(&stats->image_surfaces, surface_bytes(images[i]->surface));
+    add_usage(&stats->image_textures, texture_bytes(images[i]->texture));
+  }
+
+  S2D_Text *const *texts = S2D_GetLiveTexts(&count);
+  for (int i = 0; i < count; i++) {
+    add_usage(&stats->text_surfaces, surface_bytes(texts[i]->surface));
+    add_usage(&stats->text_textures, texture_bytes(texts[i]->texture));
+    add_usage(&stats->fonts, texts[i]->font_bytes);
+  }
+
+  // Streamed audio is counted by the size of its loaded file
+  S2D_AudioData *const *audio = S2D_GetCachedAudio(&count);
+  for (int i = 0; i < count; i++) add_usage(&stats->audio, audio[i]->bytes);
+
+  S2D_Layer *const *layers = S2D_GetLiveLayers(&count);
+  for (int i = 0; i < count; i++) add_usage(&stats->layers, texture_bytes(layers[i]->texture));
+
+  for (const S2D_Pool *pool = S2D_GetPools(); pool; pool = pool->next) {
+    stats->pools += (size_t)pool->capacity * pool->object_size;
+  }
+  S2D_GetInternedStrings(&stats->interned_strings);
+  S2D_FrameArenaStats arena;
+  S2D_GetFrameArenaStats(&arena);
+  stats->frame_arena = arena.capacity;
+
+  stats->total = stats->image_surfaces.bytes + stats->image_textures.bytes +
+    stats->text_surfaces.bytes + stats->text_textures.bytes + stats->fonts.bytes +
+    stats->audio.bytes + stats->layers.bytes + stats->pools + stats->interned_strings + stats->frame_arena;
+}
+
+
+/*
+ * Order resources by size, largest first
+ */
+static int compare_resources(const void *a, const void *b) {
+  const S2D_MemoryResource *x = (const S2D_MemoryResource *) a, *y = (const S2D_MemoryResource *) b;
+  if (x->bytes != y->bytes) return x->bytes < y->bytes ? 1 : -1;
+  return 0;
+}
+
+
+/*
+ * Write a usage line of the memory report
+ */
+static void dump_usage(FILE *f, const char *name, S2D_MemoryUsage usage) {
+  fprintf(f, "  %-16s %6d %12zu bytes\n", name, usage.count, usage.bytes);
+}
+
+
+/*
+ * Write a report of memory use to a file (like `stdout`), listing the
+ * largest resources by path, up to `max_resources`
+ */
+void S2D_DumpMemory(FILE *f, int max_resources) {
+  if (!f) return;
+  S2D_FlushLog();  // keep the report in order with log messages
+
+  S2D_MemoryStats stats;
+  S2D_GetMemoryStats(&stats);
+
+  fprintf(f, "Memory: %zu bytes\n", stats.total);
+  dump_usage(f, "Image surfaces", stats.image_surfaces);
+  dump_usage(f, "Image textures", stats.image_textures);
+  dump_usage(f, "Text surfaces", stats.text_surfaces);
+  dump_usage(f, "Text textures", stats.text_textures);
+  dump_usage(f, "Fonts", stats.fonts);
+  dump_usage(f, "Audio", stats.audio);
+  dump_usage(f, "Layers", stats.layers);
+  fprintf(f, "  %-16s %6s %12zu bytes\n", "Pools", "", stats.pools);
+  fprintf(f, "  %-16s %6s %12zu bytes\n", "Interned strings", "", stats.interned_strings);
+  fprintf(f, "  %-16s %6s %12zu bytes\n", "Frame arena", "", stats.frame_arena);
+  if (max_resources <= 0) return;
+
+  // Gather every resource, with an image's or text's surface and texture
+  // counted together, in the frame arena
+  int image_count, text_count, audio_count;
+  S2D_Image *const *images = S2D_GetLiveImages(&image_count);
+  S2D_Text *const *texts = S2D_GetLiveTexts(&text_count);
+  S2D_AudioData *const *audio = S2D_GetCachedAudio(&audio_count);
+
+  int total = image_count + text_count + audio_count;
+  S2D_MemoryResource *resources = (S2D_MemoryResource *) S2D_FrameAlloc(total * sizeof(S2D_MemoryResource));
+  if (!resources) return;
+  int count = 0;
+
+  for (int i = 0; i < image_count; i++) {
+    resources[count++] = (S2D_MemoryResource) {
+      "image", images[i]->path, surface_bytes(images[i]->surface) + texture_bytes(images[i]->texture)
+    };
+  }
+  for (int i = 0; i < text_count; i++) {
+    resources[count++] = (S2D_MemoryResource) {
+      "text", texts[i]->font,
+      surface_bytes(texts[i]->surface) + texture_bytes(texts[i]->texture) + texts[i]->font_bytes
+    };
+  }
+  for (int i = 0; i < audio_count; i++) {
+    resources[count++] = (S2D_MemoryResource) { "audio", audio[i]->path, audio[i]->bytes };
+  }
+
+  qsort(resources, count, sizeof(S2D_MemoryResource), compare_resources);
+  if (count > max_resources) count = max_resources;
+
+  fprintf(f, "Largest resources:\n");
+  for (int i = 0; i < count; i++) {
+    fprintf(f, "  %12zu bytes  %-5s  %s\n", resources[i].bytes, resources[i].kind,
+      resources[i].path ? resources[i].path : "");
+  }
+}
@@ -0,0 +1,123 @@
+// overlay.c
+
+#include "../include/simple2d.h"
+
+// 3x5 pixel glyphs, each row's bits from left to right, for the diagnostics
+// overlay (drawn as rectangles, so no fonts or textures are needed)
+static const uint8_t digit_glyphs[10][5] = {
+  {0b111, 0b101, 0b101, 0b101, 0b111}, // 0
+  {0b010, 0b110, 0b010, 0b010, 0b111}, // 1
+  {0b111, 0b001, 0b111, 0b100, 0b111}, // 2
+  {0b111, 0b001, 0b111, 0b001, 0b111}, // 3
+  {0b101, 0b101, 0b111, 0b001, 0b001}, // 4
+  {0b111, 0b100, 0b111, 0b001, 0b111}, // 5
+  {0b111, 0b100, 0b111, 0b101, 0b111}, // 6
+  {0b111, 0b001, 0b001, 0b001, 0b001}, // 7
+  {0b111, 0b101, 0b111, 0b101, 0b111}, // 8
+  {0b111, 0b101, 0b111, 0b001, 0b111}, // 9
+};
+
+static const uint8_t letter_glyphs[26][5] = {
+  {0b010, 0b101, 0b111, 0b101, 0b101}, // A
+  {0b110, 0b101, 0b110, 0b101, 0b110}, // B
+  {0b011, 0b100, 0b100, 0b100, 0b011}, // C
+  {0b110, 0b101, 0b101, 0b101, 0b110}, // D
+  {0b111, 0b100, 0b110, 0b100, 0b111}, // E
+  {0b111, 0b100, 0b110, 0b100, 0b100}, // F
+  {0b011, 0b100, 0b101, 0b101, 0b011}, // G
+  {0b101, 0b101, 0b111, 0b101, 0b101}, // H
+  {0b111, 0b010, 0b010, 0b010, 0b111}, // I
+  {0b001, 0b001, 0b001, 0b101, 0b010}, // J
+  {0b101, 0b101, 0b110, 0b101, 0b101}, // K
+  {0b100, 0b100, 0b100, 0b100, 0b111}, // L
+  {0b101, 0b111, 0b111, 0b101, 0b101}, // M
+  {0b110, 0b101, 0b101, 0b101, 0b101}, // N
+  {0b010, 0b101, 0b101, 0b101, 0b010}, // O
+  {0b110, 0b101, 0b110, 0b100, 0b100}, // P
+  {0b010, 0b101, 0b101, 0b110, 0b011}, // Q
+  {0b110, 0b101, 0b110, 0b101, 0b101}, // R
+  {0b011, 0b100, 0b010, 0b001, 0b110}, // S
+  {0b111, 0b010, 0b010, 0b010, 0b010}, // T
+  {0b101, 0b101, 0b101, 0b101, 0b111}, // U
+  {0b101, 0b101, 0b101, 0b101, 0b010}, // V
+  {0b101, 0b101, 0b111, 0b111, 0b101}, // W
+  {0b101, 0b101, 0b010, 0b101, 0b101}, // X
+  {0b101, 0b101, 0b010, 0b010, 0b010}, // Y
+  {0b111, 0b001, 0b010, 0b100, 0b111}, // Z
+};
+
+
+/*
+ * Get the glyph for a character, ignoring case, or NULL if it's drawn blank
+ */
+static const uint8_t *glyph(char c) {
+  if (c >= '0' && c <= '9') return digit_glyphs[c - '0'];
+  if (c >= 'a' && c <= 'z') return letter_glyphs[c - 'a'];
+  if (c >= 'A' && c <= 'Z') return letter_glyphs[c - 'A'];
+
+  static const uint8_t period[5]  = {0b000, 0b000, 0b000, 0b000, 0b010};
+  static const uint8_t colon[5]   = {0b000, 0b010, 0b000, 0b010, 0b000};
+  static const uint8_t dash[5]    = {0b000, 0b000, 0b111, 0b000, 0b000};
+  static const uint8_t under[5]   = {0b000, 0b000, 0b000, 0b000, 0b111};
+  static const uint8_t percent[5] = {0b101, 0b001, 0b010, 0b100, 0b101};
+  static const uint8_t slash[5]   = {0b001, 0b001, 0b010, 0b100, 0b100};
+  switch (c) {
+    case '.': return period;
+    case ':': return colon;
+    case '-': return dash;
+    case '_': return under;
+    case '%': return percent;
+    case '/': return slash;
+  }
+  return NULL;
+}
+
+
+/*
+ * Get the width of overlay text in pixels, at the given scale
+ */
+float S2D_GetOverlayTextWidth(const char *text, float scale) {
+  int len = (int) strlen(text);
+  return len > 0 ? (len * 4 - 1) * scale : 0;
+}
+
+
+/*
+ * Draw text in the diagnostics overlay's 3x5 pixel font, in renderer
+ * coordinates, with each font pixel `scale` pixels in size
+ */
+void S2D_DrawOverlayText(float x, float y, const char *text, float scale, S2D_Color color) {
+  // Collect a rectangle for each lit pixel, in the frame arena
+  int len = (int) strlen(text);
+  SDL_FRect *pixels = (SDL_FRect *) S2D_FrameAlloc(len * 15 * sizeof(SDL_FRect));
+  if (!pixels) return;
+  int count = 0;
+
+  for (int c = 0; c < len; c++, x += 4 * scale) {
+    const uint8_t *rows = glyph(text[c]);
+    if (!rows) continue;
+    for (int row = 0; row < 5; row++) {
+      for (int col = 0; col < 3; col++) {
+        if (rows[row] & (1 << (2 - col))) {
+          pixels[count++] = (SDL_FRect) { x + col * scale, y + row * scale, scale, scale };
+        }
+      }
+    }
+  }
+
+  SDL_Renderer *renderer = s2d_app.window->sdl_renderer;
+  SDL_SetRenderDrawColorFloat(renderer, color.r, color.g, color.b, color.a);
+  SDL_RenderFillRects(renderer, pixels, count);
+}
+
+
+/*
+ * Draw a semi-transparent panel behind overlay text, in renderer coordinates
+ */
+void S2D_DrawOverlayPanel(float x, float y, float width, float height) {
+  SDL_Renderer *renderer = s2d_app.window->sdl_renderer;
+  SDL_FRect background = { x, y, width, height };
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+  SDL_RenderFillRect(renderer, &background);
+}
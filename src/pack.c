@@ -0,0 +1,261 @@
+// pack.c
+
+#include "../include/simple2d.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+// A mounted asset pack, mapped into memory
+typedef struct {
+  char *path;
+  const uint8_t *data;
+  size_t size;
+  const S2D_PackEntry *entries;  // sorted by hash
+  uint32_t count;
+  const char *names;
+  size_t names_size;
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#endif
+} S2D_Pack;
+
+// Mounted packs, searched from the most recently mounted
+static S2D_Pack packs[S2D_MAX_PACKS];
+static int pack_count = 0;
+static uint64_t pack_hits = 0;
+static uint64_t pack_misses = 0;
+
+
+/*
+ * Hash an asset path using 64-bit FNV-1a, after normalizing it the same way
+ * as the packer: backslashes become slashes and leading "./" is skipped
+ */
+uint64_t S2D_HashAssetPath(const char *path) {
+  while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path += 2;
+
+  uint64_t hash = 14695981039346656037ull;
+  for (const char *c = path; *c; c++) {
+    hash ^= (uint8_t)(*c == '\\' ? '/' : *c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+
+/*
+ * Compare a stored, normalized name against a path, normalizing the path
+ */
+static bool name_matches(const char *name, uint32_t len, const char *path) {
+  while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path += 2;
+
+  for (uint32_t i = 0; i < len; i++, path++) {
+    char c = *path == '\\' ? '/' : *path;
+    if (c != name[i]) return false;
+  }
+  return *path == '\0';
+}
+
+
+/*
+ * Map a file into memory, read-only
+ */
+static const uint8_t *map_file(S2D_Pack *pack, const char *path) {
+#ifdef _WIN32
+  pack->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (pack->file == INVALID_HANDLE_VALUE) return NULL;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(pack->file, &size) || size.QuadPart == 0) {
+    CloseHandle(pack->file);
+    return NULL;
+  }
+  pack->size = (size_t)size.QuadPart;
+
+  pack->mapping = CreateFileMappingA(pack->file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!pack->mapping) {
+    CloseHandle(pack->file);
+    return NULL;
+  }
+  const uint8_t *data = (const uint8_t *) MapViewOfFile(pack->mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(pack->mapping);
+    CloseHandle(pack->file);
+  }
+  return data;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  pack->size = (size_t)st.st_size;
+
+  void *data = mmap(NULL, pack->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // the mapping keeps the file open
+  return data == MAP_FAILED ? NULL : (const uint8_t *) data;
+#endif
+}
+
+
+/*
+ * Unmap a pack's file from memory
+ */
+static void unmap_file(S2D_Pack *pack) {
+#ifdef _WIN32
+  UnmapViewOfFile(pack->data);
+  CloseHandle(pack->mapping);
+  CloseHandle(pack->file);
+#else
+  munmap((void *)pack->data, pack->size);
+#endif
+}
+
+
+/*
+ * Check that a mapped pack's header, index, and entries are within bounds
+ */
+static bool validate_pack(S2D_Pack *pack) {
+  if (pack->size < sizeof(S2D_PackHeader)) return false;
+
+  const S2D_PackHeader *header = (const S2D_PackHeader *) pack->data;
+  if (memcmp(header->magic, S2D_PACK_MAGIC, sizeof(header->magic)) != 0) return false;
+  if (header->version != S2D_PACK_VERSION) return false;
+
+  uint64_t index_size = (uint64_t)header->count * sizeof(S2D_PackEntry);
+  if (header->index_offset % 8 != 0 ||
+      header->index_offset > pack->size || index_size > pack->size - header->index_offset ||
+      header->names_offset > pack->size || header->names_size > pack->size - header->names_offset) {
+    return false;
+  }
+
+  pack->entries = (const S2D_PackEntry *)(pack->data + header->index_offset);
+  pack->count = header->count;
+  pack->names = (const char *)(pack->data + header->names_offset);
+  pack->names_size = header->names_size;
+
+  for (uint32_t i = 0; i < pack->count; i++) {
+    const S2D_PackEntry *e = &pack->entries[i];
+    if (e->offset > pack->size || e->size > pack->size - e->offset) return false;
+    if (e->name_offset > pack->names_size || e->name_len > pack->names_size - e->name_offset) return false;
+    if (i > 0 && e->hash < pack->entries[i - 1].hash) return false;
+  }
+  return true;
+}
+
+
+/*
+ * Mount an asset pack by mapping it into memory. Assets are then loaded from
+ * the most recently mounted pack containing them, before the file system.
+ */
+bool S2D_MountPack(const char *path) {
+  if (!path) return false;
+  if (pack_count == S2D_MAX_PACKS) {
+    S2D_Error("S2D_MountPack", "Cannot mount more than %d packs", S2D_MAX_PACKS);
+    return false;
+  }
+
+  S2D_Pack *pack = &packs[pack_count];
+  memset(pack, 0, sizeof(S2D_Pack));
+
+  pack->data = map_file(pack, path);
+  if (!pack->data) {
+    S2D_Error("S2D_MountPack", "Could not map pack `%s`", path);
+    return false;
+  }
+
+  if (!validate_pack(pack)) {
+    S2D_Error("S2D_MountPack", "`%s` is not a valid asset pack", path);
+    unmap_file(pack);
+    return false;
+  }
+
+  pack->path = strdup(path);
+  pack_count++;
+  S2D_Log(S2D_INFO, "Mounted pack `%s` (%u assets, %zu bytes)", path, pack->count, pack->size);
+  return true;
+}
+
+
+/*
+ * Unmount every asset pack. Assets loaded from a pack may read from its
+ * memory while in use (like streamed audio and fonts), so free them first.
+ */
+void S2D_UnmountPacks() {
+  for (int i = 0; i < pack_count; i++) {
+    unmap_file(&packs[i]);
+    free(packs[i].path);
+  }
+  if (pack_count > 0) {
+    S2D_Log(S2D_INFO, "Unmounted %d packs (%llu hits, %llu misses)", pack_count,
+      (unsigned long long)pack_hits, (unsigned long long)pack_misses);
+  }
+  pack_count = 0;
+}
+
+
+/*
+ * Find an asset in the mounted packs, given its path. Returns true and points
+ * `data` at the asset's bytes, which stay valid while the pack is mounted.
+ */
+bool S2D_FindPackAsset(const char *path, const void **data, size_t *size) {
+  if (!path || pack_count == 0) return false;
+  uint64_t hash = S2D_HashAssetPath(path);
+
+  for (int p = pack_count - 1; p >= 0; p--) {
+    S2D_Pack *pack = &packs[p];
+
+    // Binary search for the first entry with the hash, then check the names
+    uint32_t lo = 0, hi = pack->count;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (pack->entries[mid].hash < hash) lo = mid + 1;
+      else hi = mid;
+    }
+
+    for (uint32_t i = lo; i < pack->count && pack->entries[i].hash == hash; i++) {
+      const S2D_PackEntry *e = &pack->entries[i];
+      if (name_matches(pack->names + e->name_offset, e->name_len, path)) {
+        if (data) *data = pack->data + e->offset;
+        if (size) *size = (size_t)e->size;
+        pack_hits++;
+        return true;
+      }
+    }
+  }
+
+  pack_misses++;
+  return false;
+}
+
+
+/*
+ * Open an asset for reading, from the mounted packs (without copying) or the
+ * file system. Returns NULL if the asset doesn't exist.
+ */
+SDL_IOStream *S2D_OpenAsset(const char *path) {
+  if (!path || path[0] == '\0') return NULL;
+
+  const void *data;
+  size_t size;
+  if (S2D_FindPackAsset(path, &data, &size)) return SDL_IOFromConstMem(data, size);
+
+  return SDL_IOFromFile(path, "rb");
+}
+
+
+/*
+ * Returns true if an asset exists in the mounted packs or the file system
+ */
+bool S2D_AssetExists(const char *path) {
+  if (!path) return false;
+  return S2D_FindPackAsset(path, NULL, NULL) || S2D_FileExists(path);
+}
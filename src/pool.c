@@ -0,0 +1,214 @@
+// pool.c
+
+#include "../include/simple2d.h"
+
+// Pools that have allocated, for statistics and cleanup
+static S2D_Pool *pools = NULL;
+
+// An interned string, with its text stored inline after the header
+typedef struct S2D_InternEntry {
+  struct S2D_InternEntry *next;  // next entry in the same bucket
+  uint32_t hash;
+  int refs;
+  char str[];
+} S2D_InternEntry;
+
+// Table of interned strings, chained by bucket
+static S2D_InternEntry **intern_buckets = NULL;
+static int intern_bucket_count = 0;
+static int intern_count = 0;
+static size_t intern_bytes = 0;
+
+
+/*
+ * Add a new slab of objects to a pool, threading them onto its free list
+ */
+static bool grow_pool(S2D_Pool *pool) {
+  if (pool->slab_count == pool->slab_capacity) {
+    int capacity = pool->slab_capacity ? pool->slab_capacity * 2 : 8;
+    void **slabs = (void **) realloc(pool->slabs, capacity * sizeof(void *));
+    if (!slabs) return false;
+    pool->slabs = slabs;
+    pool->slab_capacity = capacity;
+  }
+
+  // Objects are at least pointer-sized and aligned, to hold the free list link
+  size_t stride = (pool->object_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+  uint8_t *slab = (uint8_t *) malloc(stride * pool->per_slab);
+  if (!slab) return false;
+
+  for (int i = pool->per_slab - 1; i >= 0; i--) {
+    void **object = (void **)(slab + i * stride);
+    *object = pool->free_list;
+    pool->free_list = object;
+  }
+
+  if (pool->slab_count == 0 && !pool->registered) {
+    pool->next = pools;
+    pools = pool;
+    pool->registered = true;
+  }
+
+  pool->slabs[pool->slab_count++] = slab;
+  pool->capacity += pool->per_slab;
+  return true;
+}
+
+
+/*
+ * Allocate a zeroed object from a pool, in constant time
+ */
+void *S2D_PoolAlloc(S2D_Pool *pool) {
+  if (!pool->free_list && !grow_pool(pool)) return NULL;
+
+  void **object = (void **) pool->free_list;
+  pool->free_list = *object;
+  pool->live++;
+  if (pool->live > pool->high_water) pool->high_water = pool->live;
+
+  memset(object, 0, pool->object_size);
+  return object;
+}
+
+
+/*
+ * Return an object to its pool, in constant time
+ */
+void S2D_PoolFree(S2D_Pool *pool, void *object) {
+  if (!object) return;
+  *(void **)object = pool->free_list;
+  pool->free_list = object;
+  pool->live--;
+}
+
+
+/*
+ * Free every slab of a pool. Objects still allocated from it become invalid.
+ */
+void S2D_FreePool(S2D_Pool *pool) {
+  if (pool->live > 0) {
+    S2D_Log(S2D_WARN, "Freeing %s pool with %d objects still in use", pool->name, pool->live);
+  }
+  for (int i = 0; i < pool->slab_count; i++) free(pool->slabs[i]);
+  free(pool->slabs);
+  pool->slabs = NULL;
+  pool->slab_count = pool->slab_capacity = 0;
+  pool->free_list = NULL;
+  pool->capacity = pool->live = 0;
+}
+
+
+/*
+ * Free the slabs of every pool that has allocated
+ */
+void S2D_FreePools() {
+  for (S2D_Pool *pool = pools; pool; pool = pool->next) S2D_FreePool(pool);
+}
+
+
+/*
+ * Get the list of pools that have allocated, linked through `next`
+ */
+const S2D_Pool *S2D_GetPools() {
+  return pools;
+}
+
+
+/*
+ * Hash a string using FNV-1a
+ */
+static uint32_t hash_string(const char *str) {
+  uint32_t hash = 2166136261u;
+  for (const char *c = str; *c; c++) {
+    hash ^= (uint8_t)*c;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+
+/*
+ * Double the number of buckets in the intern table, rehashing every entry
+ */
+static bool grow_intern_table() {
+  int count = intern_bucket_count ? intern_bucket_count * 2 : 64;
+  S2D_InternEntry **buckets = (S2D_InternEntry **) calloc(count, sizeof(S2D_InternEntry *));
+  if (!buckets) return false;
+
+  for (int i = 0; i < intern_bucket_count; i++) {
+    S2D_InternEntry *entry = intern_buckets[i];
+    while (entry) {
+      S2D_InternEntry *next = entry->next;
+      int b = entry->hash & (count - 1);
+      entry->next = buckets[b];
+      buckets[b] = entry;
+      entry = next;
+    }
+  }
+
+  free(intern_buckets);
+  intern_buckets = buckets;
+  intern_bucket_count = count;
+  return true;
+}
+
+
+/*
+ * Intern a string, returning a shared, reference-counted copy. Equal strings
+ * return the same pointer. Release it with `S2D_ReleaseString()`.
+ */
+const char *S2D_InternString(const char *str) {
+  if (!str) return NULL;
+  if (intern_count >= intern_bucket_count) grow_intern_table();
+  if (!intern_buckets) return NULL;
+
+  uint32_t hash = hash_string(str);
+  int b = hash & (intern_bucket_count - 1);
+
+  for (S2D_InternEntry *entry = intern_buckets[b]; entry; entry = entry->next) {
+    if (entry->hash == hash && strcmp(entry->str, str) == 0) {
+      entry->refs++;
+      return entry->str;
+    }
+  }
+
+  size_t len = strlen(str) + 1;
+  S2D_InternEntry *entry = (S2D_InternEntry *) malloc(sizeof(S2D_InternEntry) + len);
+  if (!entry) return NULL;
+  entry->hash = hash;
+  entry->refs = 1;
+  memcpy(entry->str, str, len);
+  entry->next = intern_buckets[b];
+  intern_buckets[b] = entry;
+  intern_count++;
+  intern_bytes += sizeof(S2D_InternEntry) + len;
+  return entry->str;
+}
+
+
+/*
+ * Release a reference to an interned string, freeing it with the last one
+ */
+void S2D_ReleaseString(const char *str) {
+  if (!str) return;
+
+  S2D_InternEntry *entry = (S2D_InternEntry *)(str - offsetof(S2D_InternEntry, str));
+  if (--entry->refs > 0) return;
+
+  S2D_InternEntry **link = &intern_buckets[entry->hash & (intern_bucket_count - 1)];
+  while (*link != entry) link = &(*link)->next;
+  *link = entry->next;
+
+  intern_count--;
+  intern_bytes -= sizeof(S2D_InternEntry) + strlen(entry->str) + 1;
+  free(entry);
+}
+
+
+/*
+ * Get the number of interned strings, and optionally the bytes they use
+ */
+int S2D_GetInternedStrings(size_t *bytes) {
+  if (bytes) *bytes = intern_bytes;
+  return intern_count;
+}
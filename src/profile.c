@@ -0,0 +1,189 @@
+// profile.c
+
+#include "../include/simple2d.h"
+
+// Most zones open at once
+#define PROFILE_STACK_SIZE 32
+
+// Weight of the newest frame in each zone's smoothed average
+#define PROFILE_SMOOTHING 0.1
+
+// Zones seen so far, found by name
+static S2D_ProfileZone zones[S2D_PROFILE_MAX_ZONES];
+static Uint64 zone_ns[S2D_PROFILE_MAX_ZONES];  // accumulated this frame
+static int zone_calls[S2D_PROFILE_MAX_ZONES];
+static int zone_count = 0;
+
+// Open zones, innermost last
+static struct {
+  int zone;
+  Uint64 start;
+} stack[PROFILE_STACK_SIZE];
+static int depth = 0;
+static int overflow = 0;  // zones begun past the top of the stack
+
+static bool enabled = false;
+
+
+/*
+ * Enable or disable profiling zones. They're also recorded in diagnostics
+ * mode, to be shown in the overlay.
+ */
+void S2D_EnableProfiler(bool status) {
+  enabled = status;
+}
+
+
+/*
+ * Find a zone by name, adding it if new. Returns -1 if there are too many.
+ */
+static int find_zone(const char *name) {
+  // Names are usually string literals, so first compare pointers
+  for (int i = 0; i < zone_count; i++) {
+    if (zones[i].name == name) return i;
+  }
+  for (int i = 0; i < zone_count; i++) {
+    if (strcmp(zones[i].name, name) == 0) return i;
+  }
+
+  if (zone_count == S2D_PROFILE_MAX_ZONES) return -1;
+  S2D_ProfileZone *z = &zones[zone_count];
+  memset(z, 0, sizeof(S2D_ProfileZone));
+  z->name = name;
+  z->depth = depth;
+  zone_ns[zone_count] = 0;
+  zone_calls[zone_count] = 0;
+  return zone_count++;
+}
+
+
+/*
+ * Begin a profiling zone, given a name that stays valid (like a string
+ * literal). Zones nest, and are also traced when tracing. Call only from the
+ * main thread.
+ */
+void S2D_ProfileBegin(const char *name) {
+  S2D_TraceBegin(name);
+  if (!enabled && !s2d_app.diagnostics) return;
+  if (depth == PROFILE_STACK_SIZE) {
+    overflow++;
+    return;
+  }
+
+  stack[depth].zone = find_zone(name);  // -1 if too many zones, and not recorded
+  stack[depth].start = SDL_GetTicksNS();
+  depth++;
+}
+
+
+/*
+ * End the innermost profiling zone
+ */
+void S2D_ProfileEnd() {
+  S2D_TraceEnd();
+  if (overflow > 0) {
+    overflow--;
+    return;
+  }
+  if (depth == 0) return;
+
+  depth--;
+  int zone = stack[depth].zone;
+  if (zone < 0) return;
+  zone_ns[zone] += SDL_GetTicksNS() - stack[depth].start;
+  zone_calls[zone]++;
+}
+
+
+/*
+ * End a zone begun with `S2D_PROFILE_SCOPE`, when it goes out of scope
+ */
+void S2D_ProfileEndScope(const char **name) {
+  S2D_ProfileEnd();
+}
+
+
+/*
+ * Aggregate this frame's zones into each zone's last, smoothed, and maximum
+ * times, then start a new frame. Called at the end of each frame.
+ */
+void S2D_EndProfileFrame() {
+  for (int i = 0; i < zone_count; i++) {
+    S2D_ProfileZone *z = &zones[i];
+    z->ms = zone_ns[i] / 1e6;
+    z->calls = zone_calls[i];
+    z->avg_ms += (z->ms - z->avg_ms) * PROFILE_SMOOTHING;
+    if (z->ms > z->max_ms) z->max_ms = z->ms;
+    zone_ns[i] = 0;
+    zone_calls[i] = 0;
+  }
+
+  // Zones left open, like when the profiler was disabled mid-frame, are dropped
+  depth = 0;
+  overflow = 0;
+}
+
+
+/*
+ * Get the zones seen so far, returning the number of zones
+ */
+int S2D_GetProfileZones(const S2D_ProfileZone **list) {
+  if (list) *list = zones;
+  return zone_count;
+}
+
+
+/*
+ * Reset every zone's times, forgetting zones seen so far
+ */
+void S2D_ResetProfiler() {
+  zone_count = 0;
+  depth = 0;
+  overflow = 0;
+}
+
+
+/*
+ * Order zones by smoothed time, slowest first
+ */
+static int compare_zones(const void *a, const void *b) {
+  const S2D_ProfileZone *x = *(const S2D_ProfileZone **) a, *y = *(const S2D_ProfileZone **) b;
+  if (x->avg_ms != y->avg_ms) return x->avg_ms < y->avg_ms ? 1 : -1;
+  return 0;
+}
+
+
+/*
+ * Draw the slowest zones in the diagnostics overlay, starting at the given
+ * height, with their smoothed and maximum times in milliseconds
+ */
+void S2D_DrawProfileOverlay(float y) {
+  if (zone_count == 0) return;
+
+  const S2D_ProfileZone **sorted = (const S2D_ProfileZone **) S2D_FrameAlloc(zone_count * sizeof(S2D_ProfileZone *));
+  if (!sorted) return;
+  for (int i = 0; i < zone_count; i++) sorted[i] = &zones[i];
+  qsort(sorted, zone_count, sizeof(S2D_ProfileZone *), compare_zones);
+
+  int count = zone_count < S2D_PROFILE_OVERLAY_ZONES ? zone_count : S2D_PROFILE_OVERLAY_ZONES;
+  float scale = (s2d_app.window->display_scale > 1) ? 4 : 2;
+  float line_height = 7 * scale;
+
+  // Format each line, then size the panel to the widest
+  char **lines = (char **) S2D_FrameAlloc(count * sizeof(char *));
+  if (!lines) return;
+  float width = 0;
+  for (int i = 0; i < count; i++) {
+    const S2D_ProfileZone *z = sorted[i];
+    lines[i] = S2D_FrameFormat("%*s%.24s %.2f / %.2f MS", z->depth, "", z->name, z->avg_ms, z->max_ms);
+    if (!lines[i]) return;
+    float w = S2D_GetOverlayTextWidth(lines[i], scale);
+    if (w > width) width = w;
+  }
+
+  y += 5;
+  S2D_DrawOverlayPanel(5, y, width + 8, count * line_height - 2 * scale + 10);
+  for (int i = 0; i < count; i++) {
+    S2D_DrawOverlayText(5 + 4, y + 5 + i * line_height, lines[i], scale, (S2D_Color){ 1, 1, 1, 1 });
+  }
+}
@@ -0,0 +1,437 @@
+// record.c
+
+#include "../include/simple2d.h"
+
+// Recording file header: magic, followed by the format version
+#define RECORD_MAGIC   "S2DREC"
+#define RECORD_VERSION 1
+
+// Internal record kinds, alongside the `S2D_ON_*` event handlers
+#define RECORD_END            0  // marks the last recorded frame
+#define RECORD_MOUSE_POSITION 4  // per-frame mouse position
+
+// Recording state
+static FILE *record_file = NULL;
+static uint64_t record_frame = 0;
+static uint64_t record_time = 0;
+static uint64_t record_start = 0;
+static uint64_t record_count = 0;  // dispatched events, not mouse positions
+static int record_mouse_x = -1;
+static int record_mouse_y = -1;
+
+// Replay state
+static uint8_t *replay_data = NULL;
+static size_t replay_size = 0;
+static size_t replay_pos = 0;
+static uint64_t replay_frame = 0;  // frame of the next pending record
+static uint64_t replay_count = 0;
+static const char **replay_names = NULL;  // interned controller names
+static int replay_name_count = 0;
+static uint64_t replay_start = 0;
+static bool replaying = false;
+
+
+/*
+ * Write an unsigned integer using a variable-length (LEB128) encoding
+ */
+static void write_varint(uint64_t value) {
+  while (value >= 0x80) {
+    fputc((int)(value & 0x7F) | 0x80, record_file);
+    value >>= 7;
+  }
+  fputc((int)value, record_file);
+}
+
+
+/*
+ * Write a signed integer using zigzag and variable-length encoding
+ */
+static void write_svarint(int64_t value) {
+  write_varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+
+/*
+ * Write a NUL-terminated string, so replayed events can point into the buffer
+ */
+static void write_string(const char *str) {
+  if (!str) str = "";
+  size_t len = strlen(str) + 1;
+  write_varint(len);
+  fwrite(str, 1, len, record_file);
+}
+
+
+/*
+ * Read an unsigned variable-length integer from the replay buffer
+ */
+static uint64_t read_varint() {
+  uint64_t value = 0;
+  int shift = 0;
+  while (replay_pos < replay_size && shift < 64) {
+    uint8_t byte = replay_data[replay_pos++];
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) break;
+    shift += 7;
+  }
+  return value;
+}
+
+
+/*
+ * Read a signed zigzag variable-length integer from the replay buffer
+ */
+static int64_t read_svarint() {
+  uint64_t value = read_varint();
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+
+/*
+ * Read a byte from the replay buffer
+ */
+static uint8_t read_byte() {
+  return replay_pos < replay_size ? replay_data[replay_pos++] : 0;
+}
+
+
+/*
+ * Read a NUL-terminated string from the replay buffer, pointing into it
+ */
+static const char *read_string() {
+  size_t len = (size_t)read_varint();
+  if (len == 0 || replay_pos + len > replay_size) {
+    replay_pos = replay_size;
+    return "";
+  }
+  const char *str = (const char *)&replay_data[replay_pos];
+  replay_pos += len;
+  return str[len - 1] == '\0' ? str : "";
+}
+
+
+/*
+ * Read a controller name from the replay buffer, interning it so events keep a
+ * valid name after the buffer is freed. Each distinct name is kept until quitting.
+ */
+static const char *read_name() {
+  const char *name = S2D_InternString(read_string());
+  if (!name) return "";
+
+  for (int i = 0; i < replay_name_count; i++) {
+    if (replay_names[i] == name) {
+      S2D_ReleaseString(name);  // already holding a reference
+      return name;
+    }
+  }
+
+  const char **names = (const char **) realloc(replay_names, (replay_name_count + 1) * sizeof(const char *));
+  if (!names) {
+    S2D_ReleaseString(name);
+    return "";
+  }
+  replay_names = names;
+  replay_names[replay_name_count++] = name;
+  return name;
+}
+
+
+/*
+ * Write the common record header: kind, frame delta, and timestamp delta
+ */
+static void write_record_header(int kind) {
+  uint64_t frame = s2d_app.window ? s2d_app.window->frames : 0;
+  uint64_t time = SDL_GetTicksNS() - record_start;
+
+  fputc(kind, record_file);
+  write_varint(frame - record_frame);
+  write_varint(time - record_time);
+
+  record_frame = frame;
+  record_time = time;
+}
+
+
+/*
+ * Append an event delivered to the given handler to the recording
+ */
+static void record_event(int handler, S2D_Event e) {
+  write_record_header(handler);
+  fputc(e.type, record_file);
+  record_count++;
+
+  switch (handler) {
+    case S2D_ON_KEY:
+      write_varint(SDL_GetScancodeFromName(e.key));
+      break;
+
+    case S2D_ON_MOUSE:
+      fputc(e.button, record_file);
+      fputc((e.dblclick ? 1 : 0) | (e.direction ? 2 : 0), record_file);
+      write_svarint(e.x);
+      write_svarint(e.y);
+      write_svarint(e.delta_x);
+      write_svarint(e.delta_y);
+      break;
+
+    case S2D_ON_CONTROLLER:
+      write_varint((uint32_t)e.id);
+      switch (e.type) {
+        case S2D_AXIS:
+          fputc(e.axis, record_file);
+          write_svarint(e.value);
+          break;
+        case S2D_BUTTON_DOWN:
+        case S2D_BUTTON_UP:
+          fputc(e.button, record_file);
+          break;
+        default:
+          write_string(e.name);
+          break;
+      }
+      break;
+  }
+}
+
+
+/*
+ * Start recording all delivered input events to a binary file
+ */
+bool S2D_StartRecording(const char *path) {
+  if (replaying) {
+    S2D_Error("S2D_StartRecording", "Cannot record while replaying input");
+    return false;
+  }
+  if (record_file) S2D_StopRecording();
+
+  record_file = fopen(path, "wb");
+  if (!record_file) {
+    S2D_Error("S2D_StartRecording", "Could not open `%s` for writing", path);
+    return false;
+  }
+
+  fwrite(RECORD_MAGIC, 1, strlen(RECORD_MAGIC), record_file);
+  fputc(RECORD_VERSION, record_file);
+
+  record_frame = s2d_app.window ? s2d_app.window->frames : 0;
+  record_start = SDL_GetTicksNS();
+  record_time = 0;
+  record_count = 0;
+  record_mouse_x = record_mouse_y = -1;
+
+  S2D_Log(S2D_INFO, "Recording input to `%s`", path);
+  return true;
+}
+
+
+/*
+ * Stop recording input and close the recording file
+ */
+void S2D_StopRecording() {
+  if (!record_file) return;
+  write_record_header(RECORD_END);
+  fclose(record_file);
+  record_file = NULL;
+  S2D_Log(S2D_INFO, "Recorded %llu input events", (unsigned long long)record_count);
+}
+
+
+/*
+ * Start replaying input from a recording, ignoring live input until it ends
+ */
+bool S2D_StartReplay(const char *path) {
+  if (record_file) {
+    S2D_Error("S2D_StartReplay", "Cannot replay while recording input");
+    return false;
+  }
+
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    S2D_Error("S2D_StartReplay", "Recording `%s` not found", path);
+    return false;
+  }
+
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  size_t header_size = strlen(RECORD_MAGIC) + 1;
+  uint8_t *data = size > 0 ? (uint8_t *) malloc(size) : NULL;
+  if (!data || fread(data, 1, size, f) != (size_t)size ||
+      (size_t)size < header_size || memcmp(data, RECORD_MAGIC, strlen(RECORD_MAGIC)) != 0) {
+    S2D_Error("S2D_StartReplay", "`%s` is not a valid input recording", path);
+    free(data);
+    fclose(f);
+    return false;
+  }
+  fclose(f);
+
+  if (data[header_size - 1] != RECORD_VERSION) {
+    S2D_Error("S2D_StartReplay", "Unsupported recording version %d", data[header_size - 1]);
+    free(data);
+    return false;
+  }
+
+  free(replay_data);
+  replay_data = data;
+  replay_size = (size_t)size;
+  replay_pos = header_size;
+  replay_count = 0;
+  replay_start = SDL_GetTicksNS();
+  replaying = true;
+
+  // Peek at the frame of the first record, relative to the current frame
+  replay_frame = s2d_app.window ? s2d_app.window->frames : 0;
+  if (replay_pos < replay_size) {
+    replay_pos++;  // skip kind
+    replay_frame += read_varint();
+    replay_pos = header_size;
+  }
+
+  S2D_Log(S2D_INFO, "Replaying input from `%s`", path);
+  return true;
+}
+
+
+/*
+ * Returns true if input is currently being replayed from a recording
+ */
+bool S2D_IsReplaying() {
+  return replaying;
+}
+
+
+/*
+ * Stop replaying, logging how long the replayed frames took
+ */
+static void stop_replay() {
+  uint64_t frames = s2d_app.window ? s2d_app.window->frames : 0;
+  double elapsed = (SDL_GetTicksNS() - replay_start) / 1e9;
+
+  S2D_Log(S2D_INFO, "Replay finished: %llu events, %llu frames in %.3f s (%.3f ms/frame)",
+    (unsigned long long)replay_count, (unsigned long long)frames, elapsed,
+    frames ? elapsed * 1000.0 / frames : 0.0);
+
+  free(replay_data);
+  replay_data = NULL;
+  replay_size = replay_pos = 0;
+  replaying = false;
+}
+
+
+/*
+ * Dispatch an event to the user's handler, recording it if enabled.
+ * Live events are dropped while replaying, so only recorded input is seen.
+ */
+void S2D_DispatchEvent(int handler, S2D_Event e) {
+  if (replaying) return;
+  if (record_file) record_event(handler, e);
+
+  switch (handler) {
+    case S2D_ON_KEY:        S2D_OnKey(e);        break;
+    case S2D_ON_MOUSE:      S2D_OnMouse(e);      break;
+    case S2D_ON_CONTROLLER: S2D_OnController(e); break;
+  }
+}
+
+
+/*
+ * Record the mouse position for the current frame, if it changed
+ */
+void S2D_RecordMousePosition(int x, int y) {
+  if (!record_file || (x == record_mouse_x && y == record_mouse_y)) return;
+  write_record_header(RECORD_MOUSE_POSITION);
+  write_svarint(x);
+  write_svarint(y);
+  record_mouse_x = x;
+  record_mouse_y = y;
+}
+
+
+/*
+ * Deliver all recorded events for the current frame, in recorded order.
+ * Called at the start of each frame; ends the app when the recording runs out.
+ */
+void S2D_ReplayFrame() {
+  if (!replaying) return;
+
+  uint64_t frame = s2d_app.window->frames;
+
+  while (replay_pos < replay_size && replay_frame <= frame) {
+    int kind = read_byte();
+    read_varint();  // frame delta, already applied to `replay_frame`
+    read_varint();  // timestamp delta
+
+    S2D_Event e = { 0 };
+
+    if (kind == RECORD_END) {
+      replay_pos = replay_size;
+      break;
+    } else if (kind == RECORD_MOUSE_POSITION) {
+      s2d_app.window->mouse.x = (int)read_svarint();
+      s2d_app.window->mouse.y = (int)read_svarint();
+    } else {
+      e.type = read_byte();
+
+      switch (kind) {
+        case S2D_ON_KEY:
+          e.key = SDL_GetScancodeName((SDL_Scancode)read_varint());
+          S2D_OnKey(e);
+          replay_count++;
+          break;
+
+        case S2D_ON_MOUSE: {
+          e.button = read_byte();
+          uint8_t flags = read_byte();
+          e.dblclick = flags & 1;
+          e.direction = (flags & 2) ? S2D_MOUSE_SCROLL_INVERTED : S2D_MOUSE_SCROLL_NORMAL;
+          e.x = (int)read_svarint();
+          e.y = (int)read_svarint();
+          e.delta_x = (int)read_svarint();
+          e.delta_y = (int)read_svarint();
+          S2D_OnMouse(e);
+          replay_count++;
+          break;
+        }
+
+        case S2D_ON_CONTROLLER:
+          e.id = (int)read_varint();
+          switch (e.type) {
+            case S2D_AXIS:
+              e.axis = read_byte();
+              e.value = (int)read_svarint();
+              break;
+            case S2D_BUTTON_DOWN:
+            case S2D_BUTTON_UP:
+              e.button = read_byte();
+              break;
+            default:
+              e.name = read_name();
+              break;
+          }
+          S2D_ApplyControllerEvent(&e);
+          S2D_OnController(e);
+          replay_count++;
+          break;
+
+        default:
+          S2D_Error("S2D_ReplayFrame", "Corrupt recording (record kind %d)", kind);
+          replay_pos = replay_size;
+          break;
+      }
+    }
+
+    // Peek at the frame of the next record
+    if (replay_pos < replay_size) {
+      size_t pos = replay_pos;
+      replay_pos++;
+      replay_frame += read_varint();
+      replay_pos = pos;
+    }
+  }
+
+  if (replay_pos >= replay_size) {
+    stop_replay();
+    S2D_Close();
+  }
+}
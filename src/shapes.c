@@ -108,7 +108,7 @@ void S2D_DrawTriangle(float x1, float y1,
   // Update coordinates for high DPI window
   S2D_WindowToRendererCoordinates(vertices, 3);
 
-  SDL_RenderGeometry(s2d_app.window->sdl_renderer, NULL, vertices, 3, NULL, 0);
+  S2D_RenderGeometry(vertices, 3, NULL, 0);
 }
 
 
@@ -154,7 +154,7 @@ void S2D_DrawQuad(float x1, float y1,
   // Update coordinates for high DPI window
   S2D_WindowToRendererCoordinates(vertices, 4);
 
-  SDL_RenderGeometry(s2d_app.window->sdl_renderer, NULL, vertices, 4, indices, 6);
+  S2D_RenderGeometry(vertices, 4, indices, 6);
 }
 
 
@@ -216,7 +216,7 @@ void S2D_DrawLine(float x1, float y1, float x2, float y2,
   // Update coordinates for high DPI window
   S2D_WindowToRendererCoordinates(vertices, 4);
 
-  SDL_RenderGeometry(s2d_app.window->sdl_renderer, NULL, vertices, 4, indices, 6);
+  S2D_RenderGeometry(vertices, 4, indices, 6);
 }
 
 
@@ -239,7 +239,9 @@ void S2D_DrawCircle(float x, float y, float radius, int sectors,
 
   // Total vertices: 1 center + (sectors + 1) edge points
   int num_vertices = sectors + 2;
-  SDL_Vertex *vertices = (SDL_Vertex *)malloc(num_vertices * sizeof(SDL_Vertex));
+  SDL_Vertex *vertices = (SDL_Vertex *)S2D_FrameAlloc(num_vertices * sizeof(SDL_Vertex));
+  int *indices = (int *)S2D_FrameAlloc(sectors * 3 * sizeof(int));
+  if (!vertices || !indices) return;
 
   // Center vertex
   vertices[0].position.x = x;
@@ -267,7 +269,6 @@ void S2D_DrawCircle(float x, float y, float radius, int sectors,
 
   // Create indices for triangle fan
   int num_indices = sectors * 3;
-  int *indices = (int *)malloc(num_indices * sizeof(int));
 
   for (int i = 0; i < sectors; i++) {
     indices[i * 3 + 0] = 0;         // Center
@@ -278,8 +279,5 @@ void S2D_DrawCircle(float x, float y, float radius, int sectors,
   // Update coordinates for high DPI window
   S2D_WindowToRendererCoordinates(vertices, num_vertices);
 
-  SDL_RenderGeometry(s2d_app.window->sdl_renderer, NULL, vertices, num_vertices, indices, num_indices);
-
-  free(vertices);
-  free(indices);
+  S2D_RenderGeometry(vertices, num_vertices, indices, num_indices);
 }
@@ -10,7 +10,13 @@ S2D_App s2d_app;
 __attribute__((weak)) void S2D_Init() {}
 __attribute__((weak)) void S2D_OnKey(S2D_Event e) {}
 __attribute__((weak)) void S2D_OnMouse(S2D_Event e) {}
+#if defined(__APPLE__)
 __attribute__((weak)) void S2D_OnController(S2D_Event e) {}
+#else
+// Aliased, so the app defining its own handler can be detected
+static void default_on_controller(S2D_Event e) {}
+__attribute__((weak, alias("default_on_controller"))) void S2D_OnController(S2D_Event e);
+#endif
 __attribute__((weak)) void S2D_Update() {}
 __attribute__((weak)) void S2D_Render() {}
 __attribute__((weak)) void S2D_Quit() {}
@@ -43,50 +49,6 @@ bool S2D_FileExists(const char *path) {
 }
 
 
-/*
- * Logs standard messages to the console
- */
-void S2D_Log(int type, const char *msg, ...) {
-
-  // Always log if diagnostics set, or if a warning or error message
-  if (s2d_app.diagnostics || type != S2D_INFO) {
-
-    va_list args;
-    va_start(args, msg);
-
-    switch (type) {
-      case S2D_INFO:
-        printf("\033[1;36mInfo:\033[0m ");
-        break;
-      case S2D_WARN:
-        printf("\033[1;33mWarning:\033[0m ");
-        break;
-      case S2D_ERROR:
-        printf("\033[1;31mError:\033[0m ");
-        break;
-    }
-
-    vprintf(msg, args);
-    printf("\n");
-    va_end(args);
-  }
-}
-
-
-/*
- * Logs Simple 2D errors to the console, with caller and message body
- */
-void S2D_Error(const char *caller, const char *msg, ...) {
-  va_list args;
-  va_start(args, msg);
-  char *fmsg;
-  vasprintf(&fmsg, msg, args);
-  S2D_Log(S2D_ERROR, "(%s) %s", caller, fmsg);
-  free(fmsg);
-  va_end(args);
-}
-
-
 /*
  * Enable/disable logging of diagnostics
  */
@@ -165,80 +127,112 @@ bool S2D_KeyIs(S2D_Event e, const char *key) {
 
 
 /*
- * Draws the frame rate in the window
+ * Draws the frame rate in the window, returning the bottom of its panel
  */
-void draw_frame_rate() {
-  // Draw FPS directly on screen using a surface (no fonts)
-  int scale = (s2d_app.window->display_scale > 1) ? 6 : 3; // Set scale for larger text
+float draw_frame_rate() {
+  // Draw FPS directly on screen as filled rectangles (no fonts or textures)
+  float scale = (s2d_app.window->display_scale > 1) ? 6 : 3; // Set scale for larger text
 
-  int digit_width = 3 * scale;
-  int digit_height = 5 * scale;
-  int char_spacing = scale; // Space between digits
   // Convert FPS to string
   char fps_str[16];
   snprintf(fps_str, sizeof(fps_str), "%.0f", s2d_app.window->fps);
 
-  // Calculate width based on number of digits
-  int len = strlen(fps_str);
-  int fps_width = len * digit_width + (len - 1) * char_spacing + 8;
-  int fps_height = digit_height + 10;
-
-  SDL_Surface *fps_surface = SDL_CreateSurface(fps_width, fps_height, SDL_PIXELFORMAT_RGBA32);
-
-  if (fps_surface) {
-    // Clear surface with semi-transparent black background
-    SDL_FillSurfaceRect(fps_surface, NULL, SDL_MapRGBA(SDL_GetPixelFormatDetails(fps_surface->format), NULL, 0, 0, 0, 180));
-
-    // Simple 3x5 digit patterns (each digit is 3 wide, 5 tall)
-    static const uint8_t digits[10][5] = {
-      {0b111, 0b101, 0b101, 0b101, 0b111}, // 0
-      {0b010, 0b110, 0b010, 0b010, 0b111}, // 1
-      {0b111, 0b001, 0b111, 0b100, 0b111}, // 2
-      {0b111, 0b001, 0b111, 0b001, 0b111}, // 3
-      {0b101, 0b101, 0b111, 0b001, 0b001}, // 4
-      {0b111, 0b100, 0b111, 0b001, 0b111}, // 5
-      {0b111, 0b100, 0b111, 0b101, 0b111}, // 6
-      {0b111, 0b001, 0b001, 0b001, 0b001}, // 7
-      {0b111, 0b101, 0b111, 0b101, 0b111}, // 8
-      {0b111, 0b101, 0b111, 0b001, 0b111}, // 9
-    };
-
-    // Draw each character
-    int x_offset = 4;
-    int y_offset = 5;
-    uint32_t white = SDL_MapRGBA(SDL_GetPixelFormatDetails(fps_surface->format), NULL, 255, 255, 255, 255);
-
-    for (int c = 0; fps_str[c] != '\0'; c++) {
-      char ch = fps_str[c];
-      if (ch >= '0' && ch <= '9') {
-        int digit = ch - '0';
-        for (int row = 0; row < 5; row++) {
-          for (int col = 0; col < 3; col++) {
-            if (digits[digit][row] & (1 << (2 - col))) {
-              SDL_Rect pixel = {
-                x_offset + col * scale,
-                y_offset + row * scale,
-                scale,
-                scale
-              };
-              SDL_FillSurfaceRect(fps_surface, &pixel, white);
-            }
-          }
-        }
-      }
-      x_offset += digit_width + char_spacing;
+  // Draw a semi-transparent black background, then the digits in white
+  float fps_width = S2D_GetOverlayTextWidth(fps_str, scale) + 8;
+  float fps_height = 5 * scale + 10;
+  S2D_DrawOverlayPanel(5, 5, fps_width, fps_height);
+  S2D_DrawOverlayText(5 + 4, 5 + 5, fps_str, scale, (S2D_Color){ 1, 1, 1, 1 });
+
+  return 5 + fps_height;
+}
+
+
+/*
+ * Describe a set of subsystems, like "audio, text", in a static buffer
+ */
+static const char *subsystem_names(int flags) {
+  static char names[64];
+  snprintf(names, sizeof(names), "video%s%s%s",
+    flags & S2D_SUBSYSTEM_AUDIO ? ", audio" : "",
+    flags & S2D_SUBSYSTEM_TEXT ? ", text" : "",
+    flags & S2D_SUBSYSTEM_CONTROLLERS ? ", controllers" : "");
+  return names;
+}
+
+
+/*
+ * Start controllers if the app handles their events, since no device events
+ * arrive until they're started. Apple's linker can't alias the default
+ * handler to detect this, so there they're always started.
+ */
+static bool start_handled_controllers() {
+  if (s2d_app.subsystems & S2D_SUBSYSTEM_CONTROLLERS) return true;
+#if !defined(__APPLE__)
+  if (S2D_OnController == default_on_controller) return true;
+#endif
+  return S2D_StartSubsystems(S2D_SUBSYSTEM_CONTROLLERS);
+}
+
+
+/*
+ * Start subsystems that haven't been started, given `S2D_SUBSYSTEM_*` flags.
+ * Audio, text, and controllers are started on first use, so apps that never
+ * use them don't pay for them; call this in `S2D_Init` to start them early.
+ */
+bool S2D_StartSubsystems(int flags) {
+  int pending = flags & ~s2d_app.subsystems;
+  if (!pending) return true;
+
+  if (pending & S2D_SUBSYSTEM_AUDIO) {
+    Uint64 phase = S2D_BeginStartupPhase();
+    bool started = SDL_InitSubSystem(SDL_INIT_AUDIO);
+    S2D_EndStartupPhase(phase, "SDL_InitSubSystem(SDL_INIT_AUDIO)");
+    if (!started) {
+      S2D_Error("SDL_InitSubSystem", SDL_GetError());
+      return false;
+    }
+
+    phase = S2D_BeginStartupPhase();
+    started = MIX_Init();
+    S2D_EndStartupPhase(phase, "MIX_Init");
+    if (!started) {
+      S2D_Error("MIX_Init", SDL_GetError());
+      return false;
     }
+  }
 
-    // Create texture from surface and render it
-    SDL_Texture *fps_texture = SDL_CreateTextureFromSurface(s2d_app.window->sdl_renderer, fps_surface);
-    if (fps_texture) {
-      SDL_SetTextureBlendMode(fps_texture, SDL_BLENDMODE_BLEND);
-      SDL_FRect dst_rect = {5.0f, 5.0f, (float)fps_width, (float)fps_height};
-      SDL_RenderTexture(s2d_app.window->sdl_renderer, fps_texture, NULL, &dst_rect);
-      SDL_DestroyTexture(fps_texture);
+  if (pending & S2D_SUBSYSTEM_TEXT) {
+    Uint64 phase = S2D_BeginStartupPhase();
+    bool started = TTF_Init();
+    S2D_EndStartupPhase(phase, "TTF_Init");
+    if (!started) {
+      S2D_Error("TTF_Init", SDL_GetError());
+      return false;
     }
-    SDL_DestroySurface(fps_surface);
   }
+
+  // Gamepads already connected are added with events after this
+  if (pending & S2D_SUBSYSTEM_CONTROLLERS) {
+    Uint64 phase = S2D_BeginStartupPhase();
+    bool started = SDL_InitSubSystem(SDL_INIT_GAMEPAD);
+    S2D_EndStartupPhase(phase, "SDL_InitSubSystem(SDL_INIT_GAMEPAD)");
+    if (!started) {
+      S2D_Error("SDL_InitSubSystem", SDL_GetError());
+      return false;
+    }
+  }
+
+  s2d_app.subsystems |= pending;
+  S2D_Log(S2D_INFO, "Started subsystems: %s", subsystem_names(s2d_app.subsystems));
+  return true;
+}
+
+
+/*
+ * Get the subsystems started so far, as `S2D_SUBSYSTEM_*` flags
+ */
+int S2D_GetStartedSubsystems() {
+  return s2d_app.subsystems;
 }
 
 
@@ -258,50 +252,102 @@ SDL_AppResult SDL_Fail() {
  */
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
 
-  s2d_app.quit = false;
+  // Time each phase of startup, up to the first presented frame
+  S2D_StartStartupProfile();
+  Uint64 phase = S2D_BeginStartupPhase();
 
-  // Check command line arguments for diagnostics flag
+  s2d_app.quit = false;
+  s2d_app.headless = false;
+  s2d_app.subsystems = 0;
+  bool start_all = false;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+
+  // Check command line arguments for diagnostics, headless, input recording,
+  // audio format, texture cache, startup profile, subsystem, log file, and trace flags
   S2D_Diagnostics(false);
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--diagnostics") == 0) {
       S2D_Diagnostics(true);
-      break;
+    } else if (strcmp(argv[i], "--headless") == 0) {
+      s2d_app.headless = true;
+    } else if (strncmp(argv[i], "--record=", 9) == 0) {
+      record_path = argv[i] + 9;
+    } else if (strncmp(argv[i], "--replay=", 9) == 0) {
+      replay_path = argv[i] + 9;
+    } else if (strncmp(argv[i], "--audio-rate=", 13) == 0) {
+      S2D_SetAudioFormat(atoi(argv[i] + 13), 0, 0);
+    } else if (strncmp(argv[i], "--audio-frames=", 15) == 0) {
+      S2D_SetAudioFormat(0, 0, atoi(argv[i] + 15));
+    } else if (strcmp(argv[i], "--audio-offline") == 0) {
+      S2D_SetAudioOffline(true);
+    } else if (strncmp(argv[i], "--texture-cache=", 16) == 0) {
+      S2D_EnableTextureCache(argv[i] + 16);
+    } else if (strcmp(argv[i], "--no-texture-cache") == 0) {
+      S2D_BypassTextureCache(true);
+    } else if (strncmp(argv[i], "--startup-profile=", 18) == 0) {
+      S2D_SetStartupProfile(argv[i] + 18);
+    } else if (strcmp(argv[i], "--start-subsystems") == 0) {
+      start_all = true;
+    } else if (strncmp(argv[i], "--log-file=", 11) == 0) {
+      S2D_SetLogFile(argv[i] + 11);
+    } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+      S2D_StartTrace(argv[i] + 8);
     }
   }
 
+  // Write log messages in the background from now on
+  S2D_StartLogThread();
+  S2D_EndStartupPhase(phase, "Command line arguments");
+
   S2D_Log(S2D_INFO, "Initializing Simple 2D");
 
-  // Initialize SDL
-  if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMEPAD)) {
-    S2D_Error("SDL_Init", SDL_GetError());
-    return SDL_APP_FAILURE;
+  // Render without a visible window, using the offscreen video driver
+  if (s2d_app.headless) {
+    S2D_Log(S2D_INFO, "Running headless");
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
   }
 
-  // Initialize SDL_ttf
-  if (!TTF_Init()) {
-    S2D_Error("TTF_Init", SDL_GetError());
+  // Initialize SDL video only; audio, text, and controllers start on first use
+  phase = S2D_BeginStartupPhase();
+  bool initialized = SDL_Init(SDL_INIT_VIDEO);
+  S2D_EndStartupPhase(phase, "SDL_Init");
+  if (!initialized) {
+    S2D_Error("SDL_Init", SDL_GetError());
     return SDL_APP_FAILURE;
   }
 
-  // Initialize SDL_mixer
-  if (!MIX_Init()) {
-    S2D_Error("MIX_Init", SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
+  // Start everything up front, if requested
+  if (start_all && !S2D_StartSubsystems(S2D_SUBSYSTEM_ALL)) return SDL_APP_FAILURE;
 
-  // Create the mixer
-  s2d_app.sdl_mixer = MIX_CreateMixerDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL);
-  if (!s2d_app.sdl_mixer) {
-    S2D_Error("MIX_CreateMixerDevice", SDL_GetError());
-    return SDL_APP_FAILURE;
-  }
+  // Start recording or replaying input before any events are delivered
+  if (record_path && !S2D_StartRecording(record_path)) return SDL_APP_FAILURE;
+  if (replay_path && !S2D_StartReplay(replay_path)) return SDL_APP_FAILURE;
 
-  // Call the user's `S2D_Init` function
+  // Call the user's `S2D_Init` function, which may configure the mixer
+  // with `S2D_SetAudioFormat` before creating any audio
+  phase = S2D_BeginStartupPhase();
   S2D_Init();
+  S2D_EndStartupPhase(phase, "S2D_Init");
+
+  // Controllers are first used by an app handling their events
+  if (!start_handled_controllers()) return SDL_APP_FAILURE;
+
+  // Create the mixer if audio was started, but not already opened by creating audio
+  if (s2d_app.subsystems & S2D_SUBSYSTEM_AUDIO) {
+    phase = S2D_BeginStartupPhase();
+    bool opened = S2D_OpenAudio();
+    S2D_EndStartupPhase(phase, "S2D_OpenAudio");
+    if (!opened) return SDL_APP_FAILURE;
+  }
 
   // Show the window
-  if (!S2D_ShowWindow()) return SDL_APP_FAILURE;
+  phase = S2D_BeginStartupPhase();
+  bool shown = S2D_ShowWindow();
+  S2D_EndStartupPhase(phase, "S2D_ShowWindow");
+  if (!shown) return SDL_APP_FAILURE;
 
+  S2D_Log(S2D_INFO, "Subsystems started at launch: %s", subsystem_names(s2d_app.subsystems));
   return SDL_APP_CONTINUE;
 }
 
@@ -314,51 +360,105 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
  */
 SDL_AppResult SDL_AppIterate(void *appstate) {
 
-  // Get and store the mouse location, mapping from window coordinates
-  // back to user logical coordinates by dividing out content_scale
-  float mx, my;
-  SDL_GetMouseState(&mx, &my);
-  float cs = s2d_app.window->display_content_scale;
-  s2d_app.window->mouse.x = (int)(mx / cs);
-  s2d_app.window->mouse.y = (int)(my / cs);
-
-  // Detect keys held down and call user's `S2D_OnKey` with the event
-  int num_keys;
-  const bool *key_state = SDL_GetKeyboardState(&num_keys);
-  for (int i = 0; i < num_keys; i++) {
-    if (key_state[i]) {
-      S2D_Event event = {
-        .type = S2D_KEY_HELD, .key = SDL_GetScancodeName((SDL_Scancode)i)
-      };
-      S2D_OnKey(event);
+  // When rendering on demand, skip iterations until a frame is needed
+  if (!S2D_ShouldRender()) return s2d_app.quit ? SDL_APP_SUCCESS : SDL_APP_CONTINUE;
+
+  // Release the last frame's transient allocations, and start a new upload budget
+  S2D_ResetFrameArena();
+  S2D_ResetUploadBudget();
+  S2D_TraceBegin("Frame");
+
+  S2D_ProfileBegin("Input");
+  if (S2D_IsReplaying()) {
+    // Deliver recorded input for this frame, including the mouse location
+    S2D_ReplayFrame();
+  } else {
+    // Get and store the mouse location, mapping from window coordinates
+    // back to user logical coordinates in the viewport
+    float mx, my;
+    SDL_GetMouseState(&mx, &my);
+    S2D_WindowToViewportCoordinates(&mx, &my);
+    s2d_app.window->mouse.x = (int)mx;
+    s2d_app.window->mouse.y = (int)my;
+    S2D_RecordMousePosition(s2d_app.window->mouse.x, s2d_app.window->mouse.y);
+
+    // Detect keys held down and call user's `S2D_OnKey` with the event
+    int num_keys;
+    const bool *key_state = SDL_GetKeyboardState(&num_keys);
+    for (int i = 0; i < num_keys; i++) {
+      if (key_state[i]) {
+        S2D_Event event = {
+          .type = S2D_KEY_HELD, .key = SDL_GetScancodeName((SDL_Scancode)i)
+        };
+        S2D_DispatchEvent(S2D_ON_KEY, event);
+      }
     }
   }
+  S2D_ProfileEnd();
 
   // Call the user's `S2D_Update` function
+  S2D_ProfileBegin("S2D_Update");
   S2D_Update();
+  S2D_ProfileEnd();
+
+  // Draw into the viewport, at its internal resolution when scaling
+  S2D_BeginViewportFrame();
+
+  // Set the renderer clear (background) color and clear the screen, unless in
+  // dirty rectangle mode, where draws are recorded and only changes drawn
+  bool dirty_rects = S2D_BeginDirtyFrame();
+  if (!dirty_rects) {
+    SDL_SetRenderDrawColorFloat(
+      s2d_app.window->sdl_renderer,
+      s2d_app.window->background.r,
+      s2d_app.window->background.g,
+      s2d_app.window->background.b,
+      s2d_app.window->background.a
+    );
+    SDL_RenderClear(s2d_app.window->sdl_renderer);
+  }
 
-  // Set the renderer clear (background) color and clear the screen
-  SDL_SetRenderDrawColorFloat(
-    s2d_app.window->sdl_renderer,
-    s2d_app.window->background.r,
-    s2d_app.window->background.g,
-    s2d_app.window->background.b,
-    s2d_app.window->background.a
-  );
-  SDL_RenderClear(s2d_app.window->sdl_renderer);
-
+  S2D_ProfileBegin("S2D_Render");
   S2D_Render();  // Call the user's `S2D_Render` function
+  S2D_ProfileEnd();
+
+  if (dirty_rects) {
+    S2D_ProfileBegin("Dirty rectangles");
+    S2D_EndDirtyFrame();
+    S2D_ProfileEnd();
+  }
+
+  S2D_ProfileBegin("Viewport");
+  S2D_EndViewportFrame();
+  S2D_ProfileEnd();
 
-  // Get actual frame rate and print if in diagnostics mode
+  // Get actual frame rate and print it, with the slowest profiling zones
+  // (as of the last frame), if in diagnostics mode
   s2d_app.window->fps = get_frame_rate();
   if (s2d_app.diagnostics) {
-    draw_frame_rate();
+    S2D_TraceBegin("Diagnostics");
+    S2D_DrawProfileOverlay(draw_frame_rate());
+    S2D_TraceEnd();
   }
 
   s2d_app.window->frames++;
 
-  // Flip the buffers to show content rendered on the back buffer
+  // Flip the buffers to show content rendered on the back buffer, finishing
+  // the startup profile with the first frame
+  Uint64 phase = s2d_app.window->frames == 1 ? S2D_BeginStartupPhase() : S2D_STARTUP_PHASE_NONE;
+  S2D_ProfileBegin("SDL_RenderPresent");
   SDL_RenderPresent(s2d_app.window->sdl_renderer);
+  S2D_ProfileEnd();
+  S2D_EndProfileFrame();
+  if (phase != S2D_STARTUP_PHASE_NONE) {
+    S2D_EndStartupPhase(phase, "First present");
+    S2D_FinishStartupProfile();
+  }
+
+  // When rendering on demand, draw again for deferred uploads and dirty layers
+  S2D_EndRedrawFrame();
+
+  S2D_TraceEnd();  // frame
 
   return s2d_app.quit ? SDL_APP_SUCCESS : SDL_APP_CONTINUE;
 }
@@ -366,14 +466,16 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
 
 /*
  * Handles SDL events and dispatches them to the appropriate Simple 2D event handlers
+ * (recorded if enabled, and dropped while replaying input)
  */
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *sdl_event) {
 
+  S2D_TraceBegin("SDL_AppEvent");
+  S2D_HandleRedrawEvent(sdl_event);
+
   float mx, my;
   SDL_GetMouseState(&mx, &my);
-  float cs = s2d_app.window->display_content_scale;
-  mx /= cs;
-  my /= cs;
+  S2D_WindowToViewportCoordinates(&mx, &my);
 
   switch (sdl_event->type) {
 
@@ -382,7 +484,7 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *sdl_event) {
         S2D_Event event = {
           .type = S2D_KEY_DOWN, .key = SDL_GetScancodeName(sdl_event->key.scancode)
         };
-        S2D_OnKey(event);
+        S2D_DispatchEvent(S2D_ON_KEY, event);
       }
       break;
     }
@@ -391,7 +493,7 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *sdl_event) {
       S2D_Event event = {
         .type = S2D_KEY_UP, .key = SDL_GetScancodeName(sdl_event->key.scancode)
       };
-      S2D_OnKey(event);
+      S2D_DispatchEvent(S2D_ON_KEY, event);
       break;
     }
 
@@ -402,7 +504,7 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *sdl_event) {
       };
       event.type = sdl_event->type == SDL_EVENT_MOUSE_BUTTON_DOWN ? S2D_MOUSE_DOWN : S2D_MOUSE_UP;
       event.dblclick = sdl_event->button.clicks == 2 ? true : false;
-      S2D_OnMouse(event);
+      S2D_DispatchEvent(S2D_ON_MOUSE, event);
       break;
     }
 
@@ -411,64 +513,39 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *sdl_event) {
         .type = S2D_MOUSE_SCROLL, .direction = sdl_event->wheel.direction,
         .delta_x = sdl_event->wheel.x, .delta_y = -sdl_event->wheel.y
       };
-      S2D_OnMouse(event);
+      S2D_DispatchEvent(S2D_ON_MOUSE, event);
       break;
     }
 
     case SDL_EVENT_MOUSE_MOTION: {
+      float dx = sdl_event->motion.xrel, dy = sdl_event->motion.yrel;
+      S2D_WindowToViewportDelta(&dx, &dy);
       S2D_Event event = {
         .type = S2D_MOUSE_MOVE,
-        .x = mx, .y = my, .delta_x = (int)(sdl_event->motion.xrel / cs), .delta_y = (int)(sdl_event->motion.yrel / cs)
+        .x = mx, .y = my, .delta_x = (int)dx, .delta_y = (int)dy
       };
-      S2D_OnMouse(event);
+      S2D_DispatchEvent(S2D_ON_MOUSE, event);
       break;
     }
 
     case SDL_EVENT_GAMEPAD_ADDED: {
-      const SDL_JoystickID id = sdl_event->gdevice.which;
-      SDL_Gamepad *pad = SDL_OpenGamepad(id);
-      if (!pad) {
-        S2D_Error("SDL_OpenGamepad", "SDL_OpenGamepad(%u) failed: %s", (unsigned)id, SDL_GetError());
-      } else {
-        S2D_Log(S2D_INFO, "Gamepad added: id=%u, name=%s", (unsigned)id, SDL_GetGamepadName(pad));
-        S2D_Event event = {
-          .type = S2D_CONTROLLER_ADDED, .id = id, .name = SDL_GetGamepadName(pad)
-        };
-        S2D_OnController(event);
-      }
+      S2D_AddController(sdl_event->gdevice.which);
       break;
     }
 
     case SDL_EVENT_GAMEPAD_REMOVED: {
-      const SDL_JoystickID id = sdl_event->gdevice.which;
-      SDL_Gamepad *pad = SDL_GetGamepadFromID(id);
-      S2D_Log(S2D_INFO, "Gamepad removed: id=%u, name=%s", (unsigned)id, SDL_GetGamepadName(pad));
-      S2D_Event event = {
-        .type = S2D_CONTROLLER_REMOVED, .id = id, .name = SDL_GetGamepadName(pad)
-      };
-      S2D_OnController(event);
-      SDL_CloseGamepad(pad);
+      S2D_RemoveController(sdl_event->gdevice.which);
       break;
     }
 
     case SDL_EVENT_GAMEPAD_AXIS_MOTION: {
-      SDL_JoystickID id = sdl_event->gaxis.which;
-      S2D_Event event = {
-        .type = S2D_AXIS, .id = id,
-        .axis = sdl_event->gaxis.axis, .value = sdl_event->gaxis.value
-      };
-      S2D_OnController(event);
+      S2D_ControllerAxis(sdl_event->gaxis.which, sdl_event->gaxis.axis, sdl_event->gaxis.value);
       break;
     }
 
     case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
     case SDL_EVENT_GAMEPAD_BUTTON_UP: {
-      SDL_JoystickID id = sdl_event->gbutton.which;
-      S2D_Event event = {
-        .type = sdl_event->gbutton.down ? S2D_BUTTON_DOWN : S2D_BUTTON_UP, .id = id,
-        .button = sdl_event->gbutton.button
-      };
-      S2D_OnController(event);
+      S2D_ControllerButton(sdl_event->gbutton.which, sdl_event->gbutton.button, sdl_event->gbutton.down);
       break;
     }
 
@@ -477,6 +554,29 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *sdl_event) {
       float cs = s2d_app.window->display_content_scale;
       s2d_app.window->width  = (int)(sdl_event->window.data1 / cs);
       s2d_app.window->height = (int)(sdl_event->window.data2 / cs);
+      S2D_UpdateViewport();
+      S2D_InvalidateLayers(false);  // those following the viewport's size
+      S2D_InvalidateDirtyRects(false);
+      break;
+    }
+
+    case SDL_EVENT_WINDOW_DISPLAY_SCALE_CHANGED: {
+      // Moved to a display with a different scale, so draw layers at the new scale
+      s2d_app.window->display_scale = SDL_GetWindowDisplayScale(s2d_app.window->sdl_window);
+      S2D_InvalidateLayers(false);
+      break;
+    }
+
+    case SDL_EVENT_RENDER_TARGETS_RESET: {
+      S2D_InvalidateLayers(false);  // content of render targets was lost
+      S2D_InvalidateDirtyRects(false);
+      break;
+    }
+
+    case SDL_EVENT_RENDER_DEVICE_RESET: {
+      S2D_InvalidateLayers(true);  // textures were lost with the device
+      S2D_InvalidateDirtyRects(true);
+      S2D_InvalidateViewport(true);
       break;
     }
 
@@ -486,6 +586,7 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *sdl_event) {
     }
   }
 
+  S2D_TraceEnd();
   return SDL_APP_CONTINUE;
 }
 
@@ -496,9 +597,28 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *sdl_event) {
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
   S2D_Quit();  // Call the user's `S2D_Quit` function
 
+  S2D_StopTrace();  // writes the trace file, if tracing
+
+  S2D_StopRecording();
+  S2D_FreeControllers();
+
   // Free library resources
+  S2D_FreeAudioVoices();
+  S2D_FreeAudioCache();
   if (s2d_app.sdl_mixer) MIX_DestroyMixer(s2d_app.sdl_mixer);
+  S2D_FreeDirtyRects();
+  S2D_FreeViewport();
+  S2D_FreeLayers();
   S2D_FreeWindow(s2d_app.window);
-  MIX_Quit();
-  TTF_Quit();
+  S2D_FreeFrameArena();
+  S2D_FreePools();
+  S2D_UnmountPacks();
+  S2D_FreeStartupProfile();
+  if (s2d_app.subsystems & S2D_SUBSYSTEM_AUDIO) MIX_Quit();
+  if (s2d_app.subsystems & S2D_SUBSYSTEM_TEXT) TTF_Quit();
+  S2D_StopLogThread();
+
+  // Free trace buffers once the mixer and log threads, which may still be
+  // adding to theirs, are gone
+  S2D_FreeTrace();
 }
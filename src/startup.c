@@ -0,0 +1,220 @@
+// startup.c
+
+#include "../include/simple2d.h"
+
+// Phases timed from the start of `SDL_AppInit` until the first frame is presented
+static S2D_StartupPhase *phases = NULL;
+static int phase_count = 0;
+static int phase_capacity = 0;
+static int depth = 0;               // nesting of phases still open
+static Uint64 startup_start = 0;    // ticks when startup began, in nanoseconds
+static Uint64 first_frame = 0;      // nanoseconds from start to the first frame
+static bool finished = false;
+static char *profile_path = NULL;   // where to write the JSON report
+
+
+/*
+ * Convert nanoseconds to milliseconds
+ */
+static double ns_to_ms(Uint64 ns) {
+  return ns / 1e6;
+}
+
+
+/*
+ * Mark the start of startup, when `SDL_AppInit` is called
+ */
+void S2D_StartStartupProfile() {
+  startup_start = SDL_GetTicksNS();
+  phase_count = 0;
+  depth = 0;
+  first_frame = 0;
+  finished = false;
+}
+
+
+/*
+ * Write the startup report as JSON to a file when startup finishes, in
+ * addition to logging it in diagnostics mode
+ */
+void S2D_SetStartupProfile(const char *path) {
+  free(profile_path);
+  profile_path = path ? strdup(path) : NULL;
+}
+
+
+/*
+ * Begin timing a startup phase, returning its start time. Returns
+ * `S2D_STARTUP_PHASE_NONE` (and the phase is not recorded) once the first
+ * frame has been presented. Every phase begun must be ended, even on failure,
+ * to keep the nesting depth right.
+ */
+Uint64 S2D_BeginStartupPhase() {
+  if (finished) return S2D_STARTUP_PHASE_NONE;
+  depth++;
+  return SDL_GetTicksNS();
+}
+
+
+/*
+ * End timing a startup phase, given its start time and a printf-style name
+ */
+void S2D_EndStartupPhase(Uint64 start, const char *name, ...) {
+  if (finished || start == S2D_STARTUP_PHASE_NONE) return;
+  Uint64 end = SDL_GetTicksNS();
+  depth--;
+
+  if (phase_count == phase_capacity) {
+    int capacity = phase_capacity ? phase_capacity * 2 : 32;
+    S2D_StartupPhase *grown = (S2D_StartupPhase *) realloc(phases, capacity * sizeof(S2D_StartupPhase));
+    if (!grown) return;
+    phases = grown;
+    phase_capacity = capacity;
+  }
+
+  S2D_StartupPhase *phase = &phases[phase_count++];
+  va_list args;
+  va_start(args, name);
+  vsnprintf(phase->name, sizeof(phase->name), name, args);
+  va_end(args);
+  phase->start_ms = ns_to_ms(start - startup_start);
+  phase->duration_ms = ns_to_ms(end - start);
+  phase->depth = depth;
+}
+
+
+/*
+ * Order phases, given their indices, by duration, longest first
+ */
+static int compare_phases(const void *a, const void *b) {
+  const S2D_StartupPhase *x = &phases[*(const int *) a], *y = &phases[*(const int *) b];
+  if (x->duration_ms != y->duration_ms) return x->duration_ms < y->duration_ms ? 1 : -1;
+  return x->start_ms < y->start_ms ? -1 : x->start_ms > y->start_ms;
+}
+
+
+/*
+ * Write a string as a JSON string literal, escaping as needed
+ */
+static void write_json_string(FILE *f, const char *str) {
+  fputc('"', f);
+  for (const char *c = str; *c; c++) {
+    if (*c == '"' || *c == '\\') fprintf(f, "\\%c", *c);
+    else if ((unsigned char)*c < 0x20) fprintf(f, "\\u%04x", (unsigned char)*c);
+    else fputc(*c, f);
+  }
+  fputc('"', f);
+}
+
+
+/*
+ * Write the startup report as JSON, with phases in the order they started
+ */
+static bool write_profile(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) return false;
+
+  fprintf(f, "{\n  \"time_to_first_frame_ms\": %.3f,\n  \"phases\": [", ns_to_ms(first_frame));
+  for (int i = 0; i < phase_count; i++) {
+    S2D_StartupPhase *phase = &phases[i];
+    fprintf(f, "%s\n    {\"name\": ", i ? "," : "");
+    write_json_string(f, phase->name);
+    fprintf(f, ", \"start_ms\": %.3f, \"duration_ms\": %.3f, \"depth\": %d}",
+      phase->start_ms, phase->duration_ms, phase->depth);
+  }
+  fprintf(f, "\n  ]\n}\n");
+
+  return fclose(f) == 0;
+}
+
+
+/*
+ * Log the phases nested directly in a parent phase (or -1 for the top level),
+ * longest first, each followed by the phases nested in it
+ */
+static void log_phases(const int *parents, int parent, double total) {
+  int *children = (int *) S2D_FrameAlloc(phase_count * sizeof(int));
+  if (!children) return;
+  int count = 0;
+  for (int i = 0; i < phase_count; i++) {
+    if (parents[i] == parent) children[count++] = i;
+  }
+  qsort(children, count, sizeof(int), compare_phases);
+
+  for (int i = 0; i < count; i++) {
+    S2D_StartupPhase *phase = &phases[children[i]];
+    S2D_Log(S2D_INFO, "  %8.2f ms %5.1f%%  %*s%s", phase->duration_ms,
+      total > 0 ? phase->duration_ms * 100 / total : 0.0, phase->depth * 2, "", phase->name);
+    log_phases(parents, children[i], total);
+  }
+}
+
+
+/*
+ * Finish profiling startup, once the first frame has been presented. Logs the
+ * phases sorted by duration in diagnostics mode, and writes the JSON report.
+ */
+void S2D_FinishStartupProfile() {
+  if (finished) return;
+  first_frame = SDL_GetTicksNS() - startup_start;
+  finished = true;
+
+  if (profile_path) {
+    if (write_profile(profile_path)) {
+      S2D_Log(S2D_INFO, "Startup profile written to `%s`", profile_path);
+    } else {
+      S2D_Error("S2D_FinishStartupProfile", "Could not write startup profile `%s`", profile_path);
+    }
+  }
+
+  if (!s2d_app.diagnostics) return;
+
+  // Phases are recorded as they end, so a phase's parent is the next one
+  // recorded at a lower depth
+  int *parents = (int *) S2D_FrameAlloc(phase_count * sizeof(int));
+  if (!parents) return;
+  for (int i = 0; i < phase_count; i++) {
+    parents[i] = -1;
+    for (int j = i + 1; j < phase_count; j++) {
+      if (phases[j].depth < phases[i].depth) {
+        parents[i] = j;
+        break;
+      }
+    }
+  }
+
+  double total = ns_to_ms(first_frame);
+  S2D_Log(S2D_INFO, "Time to first frame: %.2f ms", total);
+  log_phases(parents, -1, total);
+}
+
+
+/*
+ * Get the recorded startup phases, in the order they started. Returns the
+ * number of phases.
+ */
+int S2D_GetStartupPhases(const S2D_StartupPhase **list) {
+  if (list) *list = phases;
+  return phase_count;
+}
+
+
+/*
+ * Get the time from the start of `SDL_AppInit` to the first presented frame,
+ * in milliseconds, or 0 if the first frame hasn't been presented yet
+ */
+double S2D_GetTimeToFirstFrame() {
+  return finished ? ns_to_ms(first_frame) : 0.0;
+}
+
+
+/*
+ * Free the recorded startup phases
+ */
+void S2D_FreeStartupProfile() {
+  free(phases);
+  phases = NULL;
+  phase_count = phase_capacity = 0;
+  free(profile_path);
+  profile_path = NULL;
+}
@@ -0,0 +1,283 @@
+// stream.c
+
+#include "../include/simple2d.h"
+
+// Audio streams created and not yet freed, to count the tracks playing
+static S2D_AudioStream **stream_list = NULL;
+static int stream_count = 0;
+static int stream_capacity = 0;
+
+
+/*
+ * Round up to the next power of two
+ */
+static int next_pow2(int n) {
+  int p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+
+/*
+ * Add an audio stream to the list of live streams
+ */
+static bool track_stream(S2D_AudioStream *stream) {
+  if (stream_count == stream_capacity) {
+    int capacity = stream_capacity ? stream_capacity * 2 : 8;
+    S2D_AudioStream **list = (S2D_AudioStream **) realloc(stream_list, capacity * sizeof(S2D_AudioStream *));
+    if (!list) return false;
+    stream_list = list;
+    stream_capacity = capacity;
+  }
+  stream_list[stream_count++] = stream;
+  return true;
+}
+
+
+/*
+ * Remove an audio stream from the list of live streams
+ */
+static void untrack_stream(S2D_AudioStream *stream) {
+  for (int i = 0; i < stream_count; i++) {
+    if (stream_list[i] == stream) {
+      stream_list[i] = stream_list[--stream_count];
+      break;
+    }
+  }
+
+  if (stream_count == 0) {
+    free(stream_list);
+    stream_list = NULL;
+    stream_capacity = 0;
+  }
+}
+
+
+/*
+ * Get the number of live audio streams, and optionally how many are playing
+ */
+int S2D_GetAudioStreamCount(int *playing) {
+  if (playing) {
+    *playing = 0;
+    for (int i = 0; i < stream_count; i++) {
+      if (MIX_TrackPlaying(stream_list[i]->mix_track)) (*playing)++;
+    }
+  }
+  return stream_count;
+}
+
+
+/*
+ * Copy up to `frames` sample frames out of the ring buffer, called on the
+ * mixer thread. Returns the number of sample frames read.
+ */
+static int read_ring(S2D_AudioStream *stream, float *out, int frames) {
+  unsigned int read = (unsigned int)SDL_GetAtomicInt(&stream->read);
+  unsigned int write = (unsigned int)SDL_GetAtomicInt(&stream->write);
+  int available = (int)(write - read);
+  if (frames > available) frames = available;
+
+  int mask = stream->ring_frames - 1;
+  int start = (int)(read & mask);
+  int first = stream->ring_frames - start;
+  if (first > frames) first = frames;
+
+  int ch = stream->channels;
+  memcpy(out, &stream->ring[start * ch], first * ch * sizeof(float));
+  memcpy(&out[first * ch], stream->ring, (frames - first) * ch * sizeof(float));
+
+  SDL_SetAtomicInt(&stream->read, (int)(read + frames));
+  return frames;
+}
+
+
+/*
+ * Supply PCM when the mixer asks the stream for more, called on the mixer thread
+ */
+static void SDLCALL get_stream(void *userdata, SDL_AudioStream *sdl_stream, int additional_amount, int total_amount) {
+  S2D_AudioStream *stream = (S2D_AudioStream *) userdata;
+  int frame_size = stream->channels * sizeof(float);
+  int frames = additional_amount / frame_size;
+
+  while (frames > 0) {
+    int n = frames < stream->ring_frames ? frames : stream->ring_frames;
+
+    if (stream->callback) {
+      stream->callback(stream->userdata, stream->scratch, n, stream->channels);
+    } else {
+      int got = read_ring(stream, stream->scratch, n);
+      if (got < n) {
+        memset(&stream->scratch[got * stream->channels], 0, (n - got) * frame_size);
+        SDL_AddAtomicInt(&stream->underruns, 1);
+        SDL_AddAtomicInt(&stream->underrun_frames, n - got);
+      }
+    }
+
+    SDL_PutAudioStreamData(sdl_stream, stream->scratch, n * frame_size);
+    frames -= n;
+  }
+}
+
+
+/*
+ * Create an audio stream playing PCM generated by the application
+ */
+S2D_AudioStream *S2D_CreateAudioStream(int freq, int channels, int buffer_frames,
+                                       S2D_AudioStreamCallback callback, void *userdata) {
+  if (freq <= 0 || channels <= 0 || buffer_frames <= 0) {
+    S2D_Error("S2D_CreateAudioStream", "Invalid stream format: %d Hz, %d channels, %d frames",
+      freq, channels, buffer_frames);
+    return NULL;
+  }
+
+  if (!S2D_OpenAudio()) return NULL;
+
+  S2D_AudioStream *stream = (S2D_AudioStream *) calloc(1, sizeof(S2D_AudioStream));
+  if (!stream) {
+    S2D_Error("S2D_CreateAudioStream", "Out of memory!");
+    return NULL;
+  }
+
+  stream->freq = freq;
+  stream->channels = channels;
+  stream->callback = callback;
+  stream->userdata = userdata;
+  stream->ring_frames = next_pow2(buffer_frames);
+
+  // The ring is only needed when no callback generates the samples
+  stream->scratch = (float *) malloc(stream->ring_frames * channels * sizeof(float));
+  if (!callback) stream->ring = (float *) malloc(stream->ring_frames * channels * sizeof(float));
+  if (!stream->scratch || (!callback && !stream->ring)) {
+    S2D_Error("S2D_CreateAudioStream", "Out of memory!");
+    S2D_FreeAudioStream(stream);
+    return NULL;
+  }
+
+  SDL_AudioSpec spec = { SDL_AUDIO_F32, channels, freq };
+  stream->sdl_stream = SDL_CreateAudioStream(&spec, NULL);
+  if (!stream->sdl_stream) {
+    S2D_Error("SDL_CreateAudioStream", SDL_GetError());
+    S2D_FreeAudioStream(stream);
+    return NULL;
+  }
+  SDL_SetAudioStreamGetCallback(stream->sdl_stream, get_stream, stream);
+
+  stream->mix_track = MIX_CreateTrack(s2d_app.sdl_mixer);
+  if (!stream->mix_track || !MIX_SetTrackAudioStream(stream->mix_track, stream->sdl_stream)) {
+    S2D_Error("MIX_SetTrackAudioStream", SDL_GetError());
+    S2D_FreeAudioStream(stream);
+    return NULL;
+  }
+
+  if (!track_stream(stream)) {
+    S2D_Error("S2D_CreateAudioStream", "Out of memory!");
+    S2D_FreeAudioStream(stream);
+    return NULL;
+  }
+
+  return stream;
+}
+
+
+/*
+ * Write interleaved float samples to the stream's ring buffer
+ */
+int S2D_WriteAudioStream(S2D_AudioStream *stream, const float *samples, int frames) {
+  if (!stream || !stream->ring || !samples || frames <= 0) return 0;
+
+  unsigned int write = (unsigned int)SDL_GetAtomicInt(&stream->write);
+  int space = S2D_GetAudioStreamSpace(stream);
+  if (frames > space) frames = space;
+
+  int mask = stream->ring_frames - 1;
+  int start = (int)(write & mask);
+  int first = stream->ring_frames - start;
+  if (first > frames) first = frames;
+
+  int ch = stream->channels;
+  memcpy(&stream->ring[start * ch], samples, first * ch * sizeof(float));
+  memcpy(stream->ring, &samples[first * ch], (frames - first) * ch * sizeof(float));
+
+  // Publish the samples only after they're copied
+  SDL_SetAtomicInt(&stream->write, (int)(write + frames));
+  return frames;
+}
+
+
+/*
+ * Get the number of sample frames that can be written without blocking
+ */
+int S2D_GetAudioStreamSpace(S2D_AudioStream *stream) {
+  if (!stream || !stream->ring) return 0;
+  unsigned int read = (unsigned int)SDL_GetAtomicInt(&stream->read);
+  unsigned int write = (unsigned int)SDL_GetAtomicInt(&stream->write);
+  return stream->ring_frames - (int)(write - read);
+}
+
+
+/*
+ * Get the number of underruns, and optionally the number of silent frames inserted
+ */
+int S2D_GetAudioStreamUnderruns(S2D_AudioStream *stream, int *frames) {
+  if (!stream) return 0;
+  if (frames) *frames = SDL_GetAtomicInt(&stream->underrun_frames);
+  return SDL_GetAtomicInt(&stream->underruns);
+}
+
+
+/*
+ * Play the audio stream
+ */
+void S2D_PlayAudioStream(S2D_AudioStream *stream) {
+  if (!stream) return;
+  if (!MIX_PlayTrack(stream->mix_track, 0)) {
+    S2D_Error("MIX_PlayTrack", SDL_GetError());
+  }
+}
+
+
+/*
+ * Stop the audio stream
+ */
+void S2D_StopAudioStream(S2D_AudioStream *stream) {
+  if (!stream) return;
+  MIX_StopTrack(stream->mix_track, 0);
+}
+
+
+/*
+ * Set the volume of the audio stream (percentage, 0-100)
+ */
+void S2D_SetAudioStreamVolume(S2D_AudioStream *stream, int volume) {
+  if (!stream) return;
+  if (volume < 0) volume = 0;
+  if (volume > 100) volume = 100;
+
+  if (!MIX_SetTrackGain(stream->mix_track, (float) volume / 100.0f)) {
+    S2D_Error("MIX_SetTrackGain", SDL_GetError());
+  }
+}
+
+
+/*
+ * Free the audio stream
+ */
+void S2D_FreeAudioStream(S2D_AudioStream *stream) {
+  if (!stream) return;
+  untrack_stream(stream);
+
+  // Detach from the mixer before the stream's buffers go away
+  if (stream->mix_track) MIX_DestroyTrack(stream->mix_track);
+  if (stream->sdl_stream) SDL_DestroyAudioStream(stream->sdl_stream);
+
+  int underrun_frames;
+  int underruns = S2D_GetAudioStreamUnderruns(stream, &underrun_frames);
+  if (underruns > 0) {
+    S2D_Log(S2D_INFO, "Audio stream freed after %d underruns (%d silent frames)",
+      underruns, underrun_frames);
+  }
+
+  free(stream->ring);
+  free(stream->scratch);
+  free(stream);
+}
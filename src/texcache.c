@@ -0,0 +1,438 @@
+// texcache.c
+
+#include "../include/simple2d.h"
+
+// Cache file header magic and format version
+#define TEXCACHE_MAGIC   "S2DTEX"
+#define TEXCACHE_VERSION 1
+
+// LZ4-style block compression parameters
+#define LZ_MIN_MATCH     4
+#define LZ_HASH_BITS     12
+#define LZ_LAST_LITERALS 5   // the block always ends with literals
+#define LZ_MATCH_LIMIT   12  // no match may start this close to the end
+#define LZ_MAX_OFFSET    65535
+
+// Header of a cached texture file, followed by the source path and the
+// compressed pixel data
+typedef struct {
+  char magic[6];
+  uint16_t version;
+  uint32_t format;         // SDL_PixelFormat of the pixels
+  int32_t width;
+  int32_t height;
+  int32_t pitch;
+  uint64_t source_size;    // size of the source image file
+  int64_t source_mtime;    // modification time, or content hash for packed assets
+  uint32_t path_len;
+  uint32_t checksum;       // FNV-1a of the uncompressed pixels
+  uint64_t raw_size;       // pitch * height
+  uint64_t compressed_size;
+} S2D_TextureCacheHeader;
+
+// Cache settings and statistics
+static char *cache_dir = NULL;
+static bool cache_bypass = false;
+static S2D_TextureCacheStats stats;
+
+// Renderer's preferred format, remembered in the cache directory from an
+// earlier run for images created before the renderer
+static SDL_PixelFormat renderer_format = SDL_PIXELFORMAT_UNKNOWN;
+
+
+/*
+ * Hash bytes using 64-bit FNV-1a
+ */
+static uint64_t hash_bytes(const void *data, size_t size) {
+  const uint8_t *p = (const uint8_t *) data;
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+
+/*
+ * Read 4 bytes, unaligned
+ */
+static uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+
+/*
+ * Write a length beyond a token's 4-bit field as a run of bytes
+ */
+static bool write_length(uint8_t **op, const uint8_t *end, size_t len) {
+  while (len >= 255) {
+    if (*op >= end) return false;
+    *(*op)++ = 255;
+    len -= 255;
+  }
+  if (*op >= end) return false;
+  *(*op)++ = (uint8_t)len;
+  return true;
+}
+
+
+/*
+ * Compress a block using an LZ4-style byte format. Returns the compressed
+ * size, or 0 if the output wouldn't fit in `capacity`.
+ */
+static size_t lz_compress(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity) {
+  static uint32_t table[1 << LZ_HASH_BITS];  // position + 1 of the last 4-byte sequence
+  memset(table, 0, sizeof(table));
+
+  const uint8_t *end = dst + capacity;
+  uint8_t *op = dst;
+  size_t ip = 0, anchor = 0;
+
+  while (size > LZ_MATCH_LIMIT && ip < size - LZ_MATCH_LIMIT) {
+    uint32_t seq = read32(src + ip);
+    uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+    size_t ref = table[h];
+    table[h] = (uint32_t)ip + 1;
+
+    if (!ref || ip - (ref - 1) > LZ_MAX_OFFSET || read32(src + ref - 1) != seq) {
+      ip++;
+      continue;
+    }
+    ref--;
+
+    size_t match = LZ_MIN_MATCH;
+    while (ip + match < size - LZ_LAST_LITERALS && src[ref + match] == src[ip + match]) match++;
+
+    // Token, literals, offset, then match length
+    size_t literals = ip - anchor;
+    if (op >= end) return 0;
+    uint8_t *token = op++;
+    *token = (uint8_t)(((literals < 15 ? literals : 15) << 4) |
+                       (match - LZ_MIN_MATCH < 15 ? match - LZ_MIN_MATCH : 15));
+    if (literals >= 15 && !write_length(&op, end, literals - 15)) return 0;
+    if ((size_t)(end - op) < literals + 2) return 0;
+    memcpy(op, src + anchor, literals);
+    op += literals;
+    *op++ = (uint8_t)((ip - ref) & 0xFF);
+    *op++ = (uint8_t)((ip - ref) >> 8);
+    if (match - LZ_MIN_MATCH >= 15 && !write_length(&op, end, match - LZ_MIN_MATCH - 15)) return 0;
+
+    ip += match;
+    anchor = ip;
+  }
+
+  // Remaining literals
+  size_t literals = size - anchor;
+  if (op >= end) return 0;
+  *op++ = (uint8_t)((literals < 15 ? literals : 15) << 4);
+  if (literals >= 15 && !write_length(&op, end, literals - 15)) return 0;
+  if ((size_t)(end - op) < literals) return 0;
+  memcpy(op, src + anchor, literals);
+  op += literals;
+
+  return op - dst;
+}
+
+
+/*
+ * Decompress an LZ4-style block, validating every length and offset.
+ * Returns true if exactly `size` bytes were produced.
+ */
+static bool lz_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t size) {
+  size_t ip = 0, op = 0;
+
+  while (ip < src_size) {
+    uint8_t token = src[ip++];
+
+    size_t literals = token >> 4;
+    if (literals == 15) {
+      uint8_t b;
+      do {
+        if (ip >= src_size) return false;
+        b = src[ip++];
+        literals += b;
+      } while (b == 255);
+    }
+    if (literals > src_size - ip || literals > size - op) return false;
+    memcpy(dst + op, src + ip, literals);
+    ip += literals;
+    op += literals;
+
+    if (ip >= src_size) break;  // the last sequence has only literals
+
+    if (src_size - ip < 2) return false;
+    size_t offset = src[ip] | (src[ip + 1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op) return false;
+
+    size_t match = token & 15;
+    if (match == 15) {
+      uint8_t b;
+      do {
+        if (ip >= src_size) return false;
+        b = src[ip++];
+        match += b;
+      } while (b == 255);
+    }
+    match += LZ_MIN_MATCH;
+    if (match > size - op) return false;
+
+    // Byte by byte, since the match may overlap the output
+    for (size_t i = 0; i < match; i++, op++) dst[op] = dst[op - offset];
+  }
+
+  return op == size;
+}
+
+
+/*
+ * Get the identity of an image source: its size and modification time, or for
+ * assets in a mounted pack, its size and a hash of its contents
+ */
+static bool source_key(const char *path, uint64_t *size, int64_t *mtime) {
+  const void *data;
+  size_t data_size;
+  if (S2D_FindPackAsset(path, &data, &data_size)) {
+    *size = data_size;
+    *mtime = (int64_t)hash_bytes(data, data_size);
+    return true;
+  }
+
+  SDL_PathInfo info;
+  if (!SDL_GetPathInfo(path, &info)) return false;
+  *size = info.size;
+  *mtime = info.modify_time;
+  return true;
+}
+
+
+/*
+ * Get the cache file path for a source path, in the frame arena
+ */
+static char *cache_file(const char *path, const char *ext) {
+  return S2D_FrameFormat("%s/%016llx.%s", cache_dir,
+    (unsigned long long)hash_bytes(path, strlen(path)), ext);
+}
+
+
+/*
+ * Get the renderer's preferred texture format, so cached pixels upload without
+ * conversion. Before the renderer exists, use the format it preferred on an
+ * earlier run, if known.
+ */
+static SDL_PixelFormat preferred_format() {
+  if (s2d_app.window && s2d_app.window->sdl_renderer) {
+    const SDL_PixelFormat *formats = (const SDL_PixelFormat *) SDL_GetPointerProperty(
+      SDL_GetRendererProperties(s2d_app.window->sdl_renderer), SDL_PROP_RENDERER_TEXTURE_FORMATS_POINTER, NULL
+    );
+    if (formats && formats[0] != SDL_PIXELFORMAT_UNKNOWN) return formats[0];
+  }
+  if (renderer_format != SDL_PIXELFORMAT_UNKNOWN) return renderer_format;
+  return SDL_PIXELFORMAT_RGBA32;
+}
+
+
+/*
+ * Remember the renderer's preferred texture format in the cache directory,
+ * called once the renderer is created. On later runs, images created before
+ * the renderer are cached in this format.
+ */
+void S2D_RememberTextureCacheFormat() {
+  if (!cache_dir || !s2d_app.window->sdl_renderer) return;
+  SDL_PixelFormat format = preferred_format();
+  if (format == renderer_format) return;
+
+  uint32_t value = (uint32_t)format;
+  FILE *f = fopen(S2D_FrameFormat("%s/renderer.format", cache_dir), "wb");
+  if (!f || fwrite(&value, sizeof(value), 1, f) != 1) {
+    S2D_Log(S2D_WARN, "Could not write the texture cache's renderer format");
+  }
+  if (f) fclose(f);
+  renderer_format = format;
+}
+
+
+/*
+ * Enable the decoded texture cache, storing files in the given directory,
+ * or disable it given NULL
+ */
+void S2D_EnableTextureCache(const char *dir) {
+  free(cache_dir);
+  cache_dir = NULL;
+  if (!dir) return;
+
+  if (!SDL_CreateDirectory(dir)) {
+    S2D_Error("S2D_EnableTextureCache", "Could not create cache directory `%s`: %s", dir, SDL_GetError());
+    return;
+  }
+  cache_dir = strdup(dir);
+  S2D_Log(S2D_INFO, "Texture cache enabled in `%s`", dir);
+
+  // Read the renderer format remembered from an earlier run, if any
+  uint32_t value = SDL_PIXELFORMAT_UNKNOWN;
+  FILE *f = fopen(S2D_FrameFormat("%s/renderer.format", dir), "rb");
+  if (f) {
+    if (fread(&value, sizeof(value), 1, f) != 1) value = SDL_PIXELFORMAT_UNKNOWN;
+    fclose(f);
+  }
+  renderer_format = (SDL_PixelFormat)value;
+}
+
+
+/*
+ * Bypass the texture cache, always decoding images from their source
+ */
+void S2D_BypassTextureCache(bool bypass) {
+  cache_bypass = bypass;
+}
+
+
+/*
+ * Load an image's decoded pixels from the cache. Returns NULL if the cache is
+ * disabled, or the entry is missing, stale, or invalid.
+ */
+SDL_Surface *S2D_LoadCachedSurface(const char *path) {
+  if (!cache_dir || cache_bypass || !path) return NULL;
+
+  uint64_t source_size;
+  int64_t source_mtime;
+  if (!source_key(path, &source_size, &source_mtime)) return NULL;
+
+  FILE *f = fopen(cache_file(path, "s2dtex"), "rb");
+  if (!f) {
+    stats.misses++;
+    return NULL;
+  }
+
+  S2D_TextureCacheHeader h;
+  size_t path_len = strlen(path);
+  char *stored_path = NULL;
+  uint8_t *compressed = NULL;
+  SDL_Surface *surface = NULL;
+
+  bool valid = fread(&h, sizeof(h), 1, f) == 1 &&
+    memcmp(h.magic, TEXCACHE_MAGIC, sizeof(h.magic)) == 0 && h.version == TEXCACHE_VERSION &&
+    h.source_size == source_size && h.source_mtime == source_mtime && h.path_len == path_len &&
+    h.format == (uint32_t)preferred_format() &&
+    h.width > 0 && h.height > 0 && h.pitch > 0 && h.raw_size == (uint64_t)h.pitch * h.height &&
+    h.compressed_size > 0 && h.compressed_size <= h.raw_size + h.raw_size / 255 + 16;
+
+  if (valid) {
+    stored_path = (char *) S2D_FrameAlloc(path_len);
+    valid = stored_path && fread(stored_path, 1, path_len, f) == path_len &&
+      memcmp(stored_path, path, path_len) == 0;
+  }
+
+  if (valid) {
+    compressed = (uint8_t *) malloc(h.compressed_size);
+    surface = SDL_CreateSurface(h.width, h.height, (SDL_PixelFormat)h.format);
+    valid = compressed && surface && surface->pitch == h.pitch &&
+      fread(compressed, 1, h.compressed_size, f) == h.compressed_size &&
+      lz_decompress(compressed, h.compressed_size, (uint8_t *) surface->pixels, h.raw_size) &&
+      (uint32_t)hash_bytes(surface->pixels, h.raw_size) == h.checksum;
+  }
+
+  fclose(f);
+  free(compressed);
+
+  if (!valid) {
+    if (surface) SDL_DestroySurface(surface);
+    stats.rejected++;
+    S2D_Log(S2D_WARN, "Texture cache entry for `%s` is stale or invalid", path);
+    return NULL;
+  }
+
+  stats.hits++;
+  stats.bytes_read += sizeof(h) + path_len + h.compressed_size;
+  return surface;
+}
+
+
+/*
+ * Store an image's decoded pixels in the cache, converting them to the
+ * renderer's preferred format. Returns the surface to use, which replaces
+ * (and frees) the given surface if it was converted.
+ */
+SDL_Surface *S2D_StoreCachedSurface(const char *path, SDL_Surface *surface) {
+  if (!cache_dir || cache_bypass || !path || !surface) return surface;
+
+  uint64_t source_size;
+  int64_t source_mtime;
+  if (!source_key(path, &source_size, &source_mtime)) return surface;
+
+  SDL_PixelFormat format = preferred_format();
+  if (surface->format != format) {
+    SDL_Surface *converted = SDL_ConvertSurface(surface, format);
+    if (converted) {
+      SDL_DestroySurface(surface);
+      surface = converted;
+    }
+  }
+
+  size_t path_len = strlen(path);
+  S2D_TextureCacheHeader h = {
+    .version = TEXCACHE_VERSION,
+    .format = (uint32_t)surface->format,
+    .width = surface->w,
+    .height = surface->h,
+    .pitch = surface->pitch,
+    .source_size = source_size,
+    .source_mtime = source_mtime,
+    .path_len = (uint32_t)path_len,
+    .raw_size = (uint64_t)surface->pitch * surface->h,
+  };
+  memcpy(h.magic, TEXCACHE_MAGIC, sizeof(h.magic));
+
+  if (!SDL_LockSurface(surface)) return surface;
+  h.checksum = (uint32_t)hash_bytes(surface->pixels, h.raw_size);
+
+  size_t capacity = h.raw_size + h.raw_size / 255 + 16;
+  uint8_t *compressed = (uint8_t *) malloc(capacity);
+  if (compressed) {
+    h.compressed_size = lz_compress((const uint8_t *) surface->pixels, h.raw_size, compressed, capacity);
+  }
+  SDL_UnlockSurface(surface);
+
+  if (!compressed || h.compressed_size == 0) {
+    free(compressed);
+    return surface;
+  }
+
+  // Write to a temporary file, then rename, so readers never see a partial entry
+  char *tmp = cache_file(path, "tmp");
+  char *dst = cache_file(path, "s2dtex");
+  FILE *f = fopen(tmp, "wb");
+  bool ok = f &&
+    fwrite(&h, sizeof(h), 1, f) == 1 &&
+    fwrite(path, 1, path_len, f) == path_len &&
+    fwrite(compressed, 1, h.compressed_size, f) == h.compressed_size;
+  if (f && fclose(f) != 0) ok = false;
+  free(compressed);
+
+  if (ok) {
+    SDL_RemovePath(dst);
+    ok = SDL_RenamePath(tmp, dst);
+  }
+  if (!ok) {
+    SDL_RemovePath(tmp);
+    S2D_Log(S2D_WARN, "Could not write texture cache entry for `%s`", path);
+    return surface;
+  }
+
+  stats.stores++;
+  stats.bytes_written += sizeof(h) + path_len + h.compressed_size;
+  S2D_Log(S2D_INFO, "Cached decoded texture `%s` (%llu to %llu bytes)", path,
+    (unsigned long long)h.raw_size, (unsigned long long)h.compressed_size);
+  return surface;
+}
+
+
+/*
+ * Get statistics for the texture cache
+ */
+void S2D_GetTextureCacheStats(S2D_TextureCacheStats *out) {
+  if (out) *out = stats;
+}
@@ -2,26 +2,77 @@
 
 #include "../include/simple2d.h"
 
+// Pool of text structures
+static S2D_Pool text_pool = S2D_POOL(S2D_Text, "text", 256);
+
+// Live text, for memory accounting
+static S2D_Text **text_list = NULL;
+static int text_count = 0;
+static int text_capacity = 0;
+
 
 /*
- * Create text, given a font file path, the message, and size
+ * Add text to the list of live text
  */
-S2D_Text *S2D_CreateText(const char *font, const char *msg, int size) {
+static bool track_text(S2D_Text *txt) {
+  if (text_count == text_capacity) {
+    int capacity = text_capacity ? text_capacity * 2 : 64;
+    S2D_Text **list = (S2D_Text **) realloc(text_list, capacity * sizeof(S2D_Text *));
+    if (!list) return false;
+    text_list = list;
+    text_capacity = capacity;
+  }
+  txt->live_index = text_count;
+  text_list[text_count++] = txt;
+  return true;
+}
+
+
+/*
+ * Remove text from the list of live text, in constant time
+ */
+static void untrack_text(S2D_Text *txt) {
+  S2D_Text *last = text_list[--text_count];
+  text_list[txt->live_index] = last;
+  last->live_index = txt->live_index;
+}
+
+
+/*
+ * Get the list of live text
+ */
+S2D_Text *const *S2D_GetLiveTexts(int *count) {
+  if (count) *count = text_count;
+  return text_list;
+}
+
+
+/*
+ * Open the font and render the message of new text
+ */
+static S2D_Text *create_text(const char *font, const char *msg, int size) {
   if (!s2d_app.window) {
     S2D_Error("S2D_CreateText", "A window must be created with `S2D_CreateWindow` before calling `S2D_CreateText`");
     return NULL;
   }
 
-  // Check if font file exists
-  if (!S2D_FileExists(font)) {
+  // Open the font from a mounted pack or the file system
+  SDL_IOStream *io = S2D_OpenAsset(font);
+  if (!io) {
     S2D_Error("S2D_CreateText", "Font file `%s` not found", font);
     return NULL;
   }
 
+  if (!S2D_StartSubsystems(S2D_SUBSYSTEM_TEXT)) {
+    SDL_CloseIO(io);
+    return NULL;
+  }
+
   // Allocate the text structure
-  S2D_Text *txt = (S2D_Text *) malloc(sizeof(S2D_Text));
+  S2D_Text *txt = (S2D_Text *) S2D_PoolAlloc(&text_pool);
   if (!txt) {
     S2D_Error("S2D_CreateText", "Out of memory!");
+    SDL_CloseIO(io);
     return NULL;
   }
 
@@ -30,8 +81,9 @@ S2D_Text *S2D_CreateText(const char *font, const char *msg, int size) {
 
   // Initialize values
   txt->msg = strdup(msg);
+  txt->msg_capacity = strlen(msg) + 1;
   txt->texture = NULL;
-  txt->font = strdup(font);
+  txt->font = S2D_InternString(font);
   txt->x = 0;
   txt->y = 0;
   txt->color.r = 1.f;
@@ -41,14 +93,17 @@ S2D_Text *S2D_CreateText(const char *font, const char *msg, int size) {
   txt->rotate = 0;
   txt->rx = 0;
   txt->ry = 0;
+  txt->live_index = -1;
 
-  // Open the font
-  txt->font_data = TTF_OpenFont(font, (int)(size * s2d_app.window->display_scale));
+  // Load the font, noting its size for memory accounting
+  Sint64 font_size = SDL_GetIOSize(io);
+  txt->font_bytes = font_size > 0 ? (size_t)font_size : 0;
+  txt->font_data = TTF_OpenFontIO(io, true, (int)(size * s2d_app.window->display_scale));
   if (!txt->font_data) {
-    S2D_Error("TTF_OpenFont", SDL_GetError());
-    free((void*)txt->font);
+    S2D_Error("TTF_OpenFontIO", SDL_GetError());
+    S2D_ReleaseString(txt->font);
     free(txt->msg);
-    free(txt);
+    S2D_PoolFree(&text_pool, txt);
     return NULL;
   }
 
@@ -58,9 +113,9 @@ S2D_Text *S2D_CreateText(const char *font, const char *msg, int size) {
   if (!txt->surface) {
     S2D_Error("TTF_RenderText_Blended", SDL_GetError());
     TTF_CloseFont(txt->font_data);
-    free((void*)txt->font);
+    S2D_ReleaseString(txt->font);
     free(txt->msg);
-    free(txt);
+    S2D_PoolFree(&text_pool, txt);
     return NULL;
   }
 
@@ -69,9 +124,9 @@ S2D_Text *S2D_CreateText(const char *font, const char *msg, int size) {
     S2D_Error("TTF_GetStringSize", SDL_GetError());
     SDL_DestroySurface(txt->surface);
     TTF_CloseFont(txt->font_data);
-    free((void*)txt->font);
+    S2D_ReleaseString(txt->font);
     free(txt->msg);
-    free(txt);
+    S2D_PoolFree(&text_pool, txt);
     return NULL;
   }
   txt->width  /= s2d_app.window->display_scale;
@@ -81,6 +136,24 @@ S2D_Text *S2D_CreateText(const char *font, const char *msg, int size) {
 }
 
 
+/*
+ * Create text, given a font file path, the message, and size
+ */
+S2D_Text *S2D_CreateText(const char *font, const char *msg, int size) {
+  Uint64 phase = S2D_BeginStartupPhase();
+  S2D_TraceBeginDetail("S2D_CreateText", font);
+  S2D_Text *txt = create_text(font, msg, size);
+  if (txt && !track_text(txt)) {
+    S2D_Error("S2D_CreateText", "Out of memory!");
+    S2D_FreeText(txt);
+    txt = NULL;
+  }
+  S2D_TraceEnd();
+  S2D_EndStartupPhase(phase, "S2D_CreateText(\"%s\")", font);
+  return txt;
+}
+
+
 /*
  * Set the text message
  */
@@ -90,12 +163,29 @@ void S2D_SetText(S2D_Text *txt, const char *msg, ...) {
   // Don't allow `msg` to be an empty string or NULL
   if (msg == NULL || strlen(msg) == 0) msg = " ";
 
-  // Format and store new text string
+  // Format the new text string in the frame arena first, since the arguments
+  // may point into the current message, like `S2D_SetText(txt, "%s!", txt->msg)`
   va_list args;
   va_start(args, msg);
-  free((void*)txt->msg);
-  vasprintf(&txt->msg, msg, args);
+  char *formatted = S2D_FrameVFormat(msg, args);
   va_end(args);
+  if (!formatted) {
+    S2D_Error("S2D_SetText", "Out of memory!");
+    return;
+  }
+
+  // Copy it into the existing buffer, growing it if needed
+  size_t len = strlen(formatted);
+  if (len >= txt->msg_capacity) {
+    char *grown = (char *) realloc(txt->msg, len + 1);
+    if (!grown) {
+      S2D_Error("S2D_SetText", "Out of memory!");
+      return;
+    }
+    txt->msg = grown;
+    txt->msg_capacity = len + 1;
+  }
+  memcpy(txt->msg, formatted, len + 1);
 
   // Save the width and height of the text
   if (!TTF_GetStringSize(txt->font_data, txt->msg, strlen(txt->msg), &txt->width, &txt->height)) {
@@ -133,23 +223,23 @@ void S2D_RotateText(S2D_Text *txt, float angle, int position) {
 }
 
 
+/*
+ * Upload text's texture ahead of its first draw, ignoring the upload budget.
+ * Returns false if the window isn't shown yet, since there's no renderer.
+ */
+bool S2D_PreloadText(S2D_Text *txt) {
+  if (!txt || !s2d_app.window->sdl_renderer) return false;
+  if (!txt->texture) txt->texture = S2D_UploadSurface(&txt->surface, false);
+  return txt->texture != NULL;
+}
+
+
 /*
  * Draw text
  */
 void S2D_DrawText(S2D_Text *txt) {
   if (!txt) return;
 
-  if (txt->texture == NULL) {
-    txt->texture = SDL_CreateTextureFromSurface(s2d_app.window->sdl_renderer, txt->surface);
-    if (!txt->texture) {
-      S2D_Error("SDL_CreateTextureFromSurface", SDL_GetError());
-      return;
-    }
-    SDL_SetTextureBlendMode(txt->texture, SDL_BLENDMODE_BLEND);
-    SDL_DestroySurface(txt->surface);
-    txt->surface = NULL;
-  }
-
   SDL_FRect dst_rect = {
     txt->x,
     txt->y,
@@ -158,16 +248,23 @@ void S2D_DrawText(S2D_Text *txt) {
   };
 
   S2D_WindowToRendererCoordinatesRect(&dst_rect);
-  SDL_SetTextureColorModFloat(txt->texture, txt->color.r, txt->color.g, txt->color.b);
-  SDL_SetTextureAlphaModFloat(txt->texture, txt->color.a);
+
+  // Upload the texture on first draw, within the frame's upload budget
+  if (txt->texture == NULL) {
+    txt->texture = S2D_UploadSurface(&txt->surface, true);
+    if (!txt->texture) {
+      if (txt->surface) S2D_DrawUploadPlaceholder(&dst_rect);
+      return;
+    }
+  }
 
   float scale = s2d_app.window->display_scale;
   SDL_FPoint center = {
     (txt->rx - txt->x) * scale,
     (txt->ry - txt->y) * scale
   };
-  SDL_RenderTextureRotated(
-    s2d_app.window->sdl_renderer, txt->texture, NULL, &dst_rect, txt->rotate, &center, SDL_FLIP_NONE
+  S2D_RenderTexture(
+    txt->texture, txt->msg, strlen(txt->msg), NULL, &dst_rect, txt->rotate, &center, txt->color
   );
 }
 
@@ -177,10 +274,11 @@ void S2D_DrawText(S2D_Text *txt) {
  */
 void S2D_FreeText(S2D_Text *txt) {
   if (!txt) return;
-  free((void*)txt->font);
+  if (txt->live_index >= 0) untrack_text(txt);
+  S2D_ReleaseString(txt->font);
   free((void*)txt->msg);
   if (txt->surface) SDL_DestroySurface(txt->surface);
   if (txt->texture) SDL_DestroyTexture(txt->texture);
   TTF_CloseFont(txt->font_data);
-  free(txt);
+  S2D_PoolFree(&text_pool, txt);
 }
@@ -0,0 +1,272 @@
+// trace.c
+
+#include "../include/simple2d.h"
+
+// A begin or end event
+typedef struct {
+  const char *name;  // static string
+  char detail[32];   // like an asset's path, truncated
+  Uint64 time;       // nanoseconds
+  char phase;        // 'B' or 'E'
+} S2D_TraceEvent;
+
+// Events recorded by a single thread, so recording never takes a lock
+typedef struct S2D_TraceBuffer {
+  S2D_TraceEvent *events;
+  int count;
+  int capacity;
+  SDL_AtomicInt recording;  // set while the thread adds an event
+  SDL_ThreadID thread;
+  bool main;
+  struct S2D_TraceBuffer *next;
+} S2D_TraceBuffer;
+
+// A thread's buffer, in thread-local storage. Buffers are freed when quitting,
+// after the library's threads stop, so a stale generation means it's gone.
+typedef struct {
+  S2D_TraceBuffer *buffer;
+  int generation;
+} S2D_TraceThread;
+
+static SDL_AtomicInt tracing;
+static char *trace_path = NULL;
+static SDL_TLSID trace_tls;
+static S2D_TraceBuffer *buffers = NULL;  // every thread's buffer, added under the lock
+static SDL_Mutex *buffers_lock = NULL;
+static SDL_ThreadID main_thread = 0;
+static SDL_AtomicInt dropped;
+static SDL_AtomicInt generation;  // of the buffers, advanced when they're freed
+
+
+/*
+ * Start recording trace events, written as Chrome trace JSON to the given
+ * file when stopped. View it in Perfetto (ui.perfetto.dev) or chrome://tracing.
+ */
+bool S2D_StartTrace(const char *path) {
+  if (!path || SDL_GetAtomicInt(&tracing)) return false;
+
+  if (!buffers_lock) buffers_lock = SDL_CreateMutex();
+  if (!buffers_lock) {
+    S2D_Error("SDL_CreateMutex", SDL_GetError());
+    return false;
+  }
+
+  // Reuse buffers from a previous trace
+  SDL_LockMutex(buffers_lock);
+  for (S2D_TraceBuffer *b = buffers; b; b = b->next) b->count = 0;
+  SDL_UnlockMutex(buffers_lock);
+
+  free(trace_path);
+  trace_path = strdup(path);
+  main_thread = SDL_GetCurrentThreadID();
+  SDL_SetAtomicInt(&dropped, 0);
+  SDL_SetAtomicInt(&tracing, 1);
+  S2D_Log(S2D_INFO, "Tracing to `%s`", path);
+  return true;
+}
+
+
+/*
+ * Returns true if trace events are being recorded
+ */
+bool S2D_IsTracing() {
+  return SDL_GetAtomicInt(&tracing) != 0;
+}
+
+
+/*
+ * Get the calling thread's buffer, creating it on first use, or again if the
+ * buffers were freed since
+ */
+static S2D_TraceBuffer *thread_buffer() {
+  S2D_TraceThread *t = (S2D_TraceThread *) SDL_GetTLS(&trace_tls);
+  if (!t) {
+    t = (S2D_TraceThread *) calloc(1, sizeof(S2D_TraceThread));
+    if (!t || !SDL_SetTLS(&trace_tls, t, free)) {
+      free(t);
+      return NULL;
+    }
+  }
+  int current = SDL_GetAtomicInt(&generation);
+  if (t->buffer && t->generation == current) return t->buffer;
+
+  S2D_TraceBuffer *b = (S2D_TraceBuffer *) calloc(1, sizeof(S2D_TraceBuffer));
+  if (!b) return NULL;
+  b->thread = SDL_GetCurrentThreadID();
+  b->main = b->thread == main_thread;
+
+  // The buffer outlives its thread, to be written when the trace stops
+  SDL_LockMutex(buffers_lock);
+  b->next = buffers;
+  buffers = b;
+  SDL_UnlockMutex(buffers_lock);
+
+  t->buffer = b;
+  t->generation = current;
+  return b;
+}
+
+
+/*
+ * Add an event to the calling thread's buffer
+ */
+static void record(char phase, const char *name, const char *detail) {
+  S2D_TraceBuffer *b = thread_buffer();
+  if (!b) return;
+
+  // Mark the buffer in use, then check the trace wasn't stopped meanwhile,
+  // so stopping either sees this event in flight or it isn't recorded
+  SDL_SetAtomicInt(&b->recording, 1);
+  if (!SDL_GetAtomicInt(&tracing)) {
+    SDL_SetAtomicInt(&b->recording, 0);
+    return;
+  }
+
+  if (b->count == b->capacity) {
+    int capacity = b->capacity ? b->capacity * 2 : 4096;
+    S2D_TraceEvent *events = b->capacity < S2D_TRACE_MAX_EVENTS ?
+      (S2D_TraceEvent *) realloc(b->events, capacity * sizeof(S2D_TraceEvent)) : NULL;
+    if (events) {
+      b->events = events;
+      b->capacity = capacity;
+    }
+  }
+
+  if (b->count < b->capacity) {
+    S2D_TraceEvent *e = &b->events[b->count++];
+    e->name = name;
+    e->phase = phase;
+    e->time = SDL_GetTicksNS();
+    if (detail) SDL_strlcpy(e->detail, detail, sizeof(e->detail));
+    else e->detail[0] = '\0';
+  } else {
+    SDL_AddAtomicInt(&dropped, 1);
+  }
+  SDL_SetAtomicInt(&b->recording, 0);
+}
+
+
+/*
+ * Begin a traced span on the calling thread, given a static name
+ */
+void S2D_TraceBegin(const char *name) {
+  if (SDL_GetAtomicInt(&tracing)) record('B', name, NULL);
+}
+
+
+/*
+ * Begin a traced span with a detail, like the path of an asset being loaded
+ */
+void S2D_TraceBeginDetail(const char *name, const char *detail) {
+  if (SDL_GetAtomicInt(&tracing)) record('B', name, detail);
+}
+
+
+/*
+ * End the calling thread's most recent traced span
+ */
+void S2D_TraceEnd() {
+  if (SDL_GetAtomicInt(&tracing)) record('E', NULL, NULL);
+}
+
+
+/*
+ * Write a string as a JSON string literal, escaping as needed
+ */
+static void write_json_string(FILE *f, const char *str) {
+  fputc('"', f);
+  for (const char *c = str; *c; c++) {
+    if (*c == '"' || *c == '\\') fprintf(f, "\\%c", *c);
+    else if ((unsigned char)*c < 0x20) fprintf(f, "\\u%04x", (unsigned char)*c);
+    else fputc(*c, f);
+  }
+  fputc('"', f);
+}
+
+
+/*
+ * Stop recording and write the trace file
+ */
+bool S2D_StopTrace() {
+  if (!SDL_GetAtomicInt(&tracing)) return false;
+  SDL_SetAtomicInt(&tracing, 0);
+
+  // Wait for threads still adding an event, which may grow their buffer
+  SDL_LockMutex(buffers_lock);
+  for (S2D_TraceBuffer *b = buffers; b; b = b->next) {
+    while (SDL_GetAtomicInt(&b->recording)) SDL_CPUPauseInstruction();
+  }
+  SDL_UnlockMutex(buffers_lock);
+
+  FILE *f = fopen(trace_path, "w");
+  if (!f) {
+    S2D_Error("S2D_StopTrace", "Could not write trace file `%s`", trace_path);
+    return false;
+  }
+
+  fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  bool first = true;
+  int total = 0;
+
+  SDL_LockMutex(buffers_lock);
+  for (S2D_TraceBuffer *b = buffers; b; b = b->next) {
+    unsigned long long tid = (unsigned long long) b->thread;
+
+    // Name the thread, for the timeline's track label
+    fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %llu, \"args\": {\"name\": \"%s\"}}",
+      first ? "" : ",\n", tid, b->main ? "main" : "worker");
+    first = false;
+
+    for (int i = 0; i < b->count; i++) {
+      S2D_TraceEvent *e = &b->events[i];
+      fprintf(f, ",\n{\"ph\": \"%c\", \"pid\": 1, \"tid\": %llu, \"ts\": %.3f", e->phase, tid, e->time / 1e3);
+      if (e->name) {
+        fprintf(f, ", \"name\": ");
+        write_json_string(f, e->name);
+      }
+      if (e->detail[0]) {
+        fprintf(f, ", \"args\": {\"detail\": ");
+        write_json_string(f, e->detail);
+        fputc('}', f);
+      }
+      fputc('}', f);
+    }
+    total += b->count;
+  }
+  SDL_UnlockMutex(buffers_lock);
+
+  fprintf(f, "\n]}\n");
+  if (fclose(f) != 0) {
+    S2D_Error("S2D_StopTrace", "Could not write trace file `%s`", trace_path);
+    return false;
+  }
+
+  int lost = SDL_GetAtomicInt(&dropped);
+  S2D_Log(lost ? S2D_WARN : S2D_INFO, "Wrote %d trace events to `%s` (%d dropped)", total, trace_path, lost);
+  return true;
+}
+
+
+/*
+ * Free every thread's trace buffer when quitting, stopping the trace first
+ * if needed. Call it only after other threads that trace, like the mixer's,
+ * have stopped, since they may still hold their buffer.
+ */
+void S2D_FreeTrace() {
+  S2D_StopTrace();
+  if (!buffers_lock) return;
+
+  // Threads that traced no longer have a buffer, and create another if traced again
+  SDL_LockMutex(buffers_lock);
+  SDL_AddAtomicInt(&generation, 1);
+  while (buffers) {
+    S2D_TraceBuffer *next = buffers->next;
+    free(buffers->events);
+    free(buffers);
+    buffers = next;
+  }
+  SDL_UnlockMutex(buffers_lock);
+
+  free(trace_path);
+  trace_path = NULL;
+}
@@ -0,0 +1,130 @@
+// upload.c
+
+#include "../include/simple2d.h"
+
+// Per-frame upload budget, where 0 is unlimited
+static size_t budget_bytes = 0;
+static int budget_count = 0;
+
+// Uploads so far this frame
+static size_t frame_bytes = 0;
+static int frame_uploads = 0;
+static int frame_deferred = 0;
+
+// Drawn in place of textures whose upload was deferred
+static S2D_Color placeholder = { 0.5f, 0.5f, 0.5f, 0.5f };
+
+static S2D_UploadStats stats;
+
+
+/*
+ * Set the per-frame texture upload budget, in bytes of pixels and number of
+ * textures, where 0 is unlimited. Draws past the budget are deferred to later
+ * frames, drawing a placeholder instead. At least one texture is uploaded each
+ * frame, so large textures are never deferred forever.
+ */
+void S2D_SetUploadBudget(size_t bytes, int count) {
+  budget_bytes = bytes;
+  budget_count = count > 0 ? count : 0;
+}
+
+
+/*
+ * Set the color of the placeholder drawn while a texture's upload is
+ * deferred; use an alpha of 0 to draw nothing
+ */
+void S2D_SetUploadPlaceholder(S2D_Color color) {
+  placeholder = color;
+}
+
+
+/*
+ * Returns true if a texture of the given size fits in this frame's budget
+ */
+static bool within_budget(size_t bytes) {
+  if (frame_uploads == 0) return true;
+  if (budget_count > 0 && frame_uploads >= budget_count) return false;
+  if (budget_bytes > 0 && frame_bytes + bytes > budget_bytes) return false;
+  return true;
+}
+
+
+/*
+ * Upload a surface to a texture, destroying the surface once uploaded. When
+ * `budgeted`, the upload is deferred if over this frame's budget. Returns the
+ * texture, or NULL if deferred or on error.
+ */
+SDL_Texture *S2D_UploadSurface(SDL_Surface **surface, bool budgeted) {
+  if (!surface || !*surface) return NULL;
+
+  size_t bytes = (size_t)(*surface)->pitch * (*surface)->h;
+  if (budgeted && !within_budget(bytes)) {
+    frame_deferred++;
+    stats.deferred++;
+    return NULL;
+  }
+
+  S2D_TraceBegin("Texture upload");
+  SDL_Texture *texture = SDL_CreateTextureFromSurface(s2d_app.window->sdl_renderer, *surface);
+  S2D_TraceEnd();
+  if (!texture) {
+    S2D_Error("SDL_CreateTextureFromSurface", SDL_GetError());
+    return NULL;
+  }
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  SDL_DestroySurface(*surface);
+  *surface = NULL;
+
+  frame_bytes += bytes;
+  frame_uploads++;
+  stats.uploads++;
+  stats.bytes += bytes;
+  if (!budgeted) stats.preloads++;
+  return texture;
+}
+
+
+/*
+ * Draw the placeholder for a deferred texture, given its renderer rectangle
+ */
+void S2D_DrawUploadPlaceholder(const SDL_FRect *rect) {
+  if (placeholder.a <= 0) return;
+  SDL_FColor c = { placeholder.r, placeholder.g, placeholder.b, placeholder.a };
+  SDL_Vertex vertices[4] = {
+    { { rect->x, rect->y }, c }, { { rect->x + rect->w, rect->y }, c },
+    { { rect->x + rect->w, rect->y + rect->h }, c }, { { rect->x, rect->y + rect->h }, c }
+  };
+  int indices[6] = { 0, 1, 2, 0, 2, 3 };
+  S2D_RenderGeometry(vertices, 4, indices, 6);
+}
+
+
+/*
+ * Start a new frame's upload budget, keeping the last frame's totals
+ */
+void S2D_ResetUploadBudget() {
+  stats.frame_uploads = frame_uploads;
+  stats.frame_bytes = frame_bytes;
+  stats.frame_deferred = frame_deferred;
+  if (frame_bytes > stats.max_frame_bytes) stats.max_frame_bytes = frame_bytes;
+  if (frame_deferred > 0) stats.deferred_frames++;
+  frame_uploads = 0;
+  frame_bytes = 0;
+  frame_deferred = 0;
+}
+
+
+/*
+ * Returns true if a texture upload was deferred in this frame
+ */
+bool S2D_UploadsDeferred() {
+  return frame_deferred > 0;
+}
+
+
+/*
+ * Get texture upload statistics
+ */
+void S2D_GetUploadStats(S2D_UploadStats *out) {
+  if (out) *out = stats;
+}
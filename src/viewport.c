@@ -0,0 +1,211 @@
+// viewport.c
+
+#include "../include/simple2d.h"
+
+// Drawn into at the internal resolution when scaling, then scaled to the window
+static SDL_Texture *target = NULL;
+static bool using_target = false;  // this frame
+static float render_scale = 1;     // renderer coordinates to target pixels
+
+// Maps window to viewport coordinates, as `(window - offset) * scale`
+static SDL_FPoint map_offset = { 0, 0 };
+static SDL_FPoint map_scale = { 1, 1 };
+
+
+/*
+ * Returns true if the viewport mode scales content to the window
+ */
+static bool scaling(int mode) {
+  return mode == S2D_SCALE || mode == S2D_STRETCH;
+}
+
+
+/*
+ * Get where the viewport is drawn in the window, in renderer pixels: fit with
+ * its aspect ratio and centered when scaling, or filling when stretching
+ */
+static SDL_FRect present_rect(int output_w, int output_h) {
+  S2D_Viewport *v = &s2d_app.window->viewport;
+  if (v->mode == S2D_STRETCH) return (SDL_FRect) { 0, 0, output_w, output_h };
+
+  float sx = (float) output_w / v->width;
+  float sy = (float) output_h / v->height;
+  float s = sx < sy ? sx : sy;
+  float w = v->width * s, h = v->height * s;
+  return (SDL_FRect) { (output_w - w) / 2, (output_h - h) / 2, w, h };
+}
+
+
+/*
+ * Size the viewport for its mode, either growing with the window or keeping
+ * the original size, and update the mapping of window coordinates (like the
+ * mouse's) to viewport coordinates
+ */
+void S2D_UpdateViewport() {
+  S2D_Window *window = s2d_app.window;
+  S2D_Viewport *v = &window->viewport;
+
+  if (v->mode == S2D_FIXED || scaling(v->mode)) {
+    v->width  = window->orig_width;
+    v->height = window->orig_height;
+  } else {
+    v->width  = window->width;
+    v->height = window->height;
+  }
+
+  // Without scaling, only the content scale maps window to user coordinates
+  float cs = window->display_content_scale;
+  map_offset = (SDL_FPoint) { 0, 0 };
+  map_scale = (SDL_FPoint) { 1 / cs, 1 / cs };
+
+  int output_w, output_h, window_w, window_h;
+  if (!scaling(v->mode) || !window->sdl_renderer || v->width <= 0 || v->height <= 0) return;
+  if (!SDL_GetRenderOutputSize(window->sdl_renderer, &output_w, &output_h) ||
+      !SDL_GetWindowSize(window->sdl_window, &window_w, &window_h) || window_w <= 0 || window_h <= 0) return;
+
+  SDL_FRect dst = present_rect(output_w, output_h);
+  float px = (float) output_w / window_w;  // renderer pixels per window coordinate
+  map_offset = (SDL_FPoint) { dst.x / px, dst.y / px };
+  map_scale = (SDL_FPoint) { v->width * px / dst.w, v->height * px / dst.h };
+}
+
+
+/*
+ * Map window coordinates, like the mouse's position, to viewport coordinates
+ */
+void S2D_WindowToViewportCoordinates(float *x, float *y) {
+  *x = (*x - map_offset.x) * map_scale.x;
+  *y = (*y - map_offset.y) * map_scale.y;
+}
+
+
+/*
+ * Map a distance in window coordinates, like the mouse's motion, to the viewport
+ */
+void S2D_WindowToViewportDelta(float *dx, float *dy) {
+  *dx *= map_scale.x;
+  *dy *= map_scale.y;
+}
+
+
+/*
+ * Get the size of the frame being drawn, in renderer coordinates
+ */
+void S2D_GetFrameSize(int *w, int *h) {
+  S2D_Window *window = s2d_app.window;
+  if (window->viewport.mode == S2D_FIXED || scaling(window->viewport.mode)) {
+    *w = (int) ceilf(window->viewport.width  * window->display_scale);
+    *h = (int) ceilf(window->viewport.height * window->display_scale);
+  } else if (!SDL_GetRenderOutputSize(window->sdl_renderer, w, h)) {
+    *w = *h = 0;
+  }
+}
+
+
+/*
+ * Get the render target the frame is drawn into, or NULL for the window
+ */
+SDL_Texture *S2D_GetViewportTarget() {
+  return using_target ? target : NULL;
+}
+
+
+/*
+ * Get the scale from renderer coordinates to the pixels of the frame's target,
+ * below 1 when drawing at a lower internal resolution
+ */
+float S2D_GetViewportRenderScale() {
+  return using_target ? render_scale : 1;
+}
+
+
+/*
+ * Begin drawing a frame in the viewport. A fixed viewport clips drawing to its
+ * original size. When scaling, drawing goes to a target at the viewport's
+ * size times its pixel scale (the display's scale by default), so a lower
+ * internal resolution draws fewer pixels.
+ */
+void S2D_BeginViewportFrame() {
+  S2D_Window *window = s2d_app.window;
+  SDL_Renderer *renderer = window->sdl_renderer;
+  S2D_Viewport *v = &window->viewport;
+  using_target = false;
+  S2D_UpdateViewport();
+
+  if (v->mode == S2D_FIXED) {
+    int w, h;
+    S2D_GetFrameSize(&w, &h);
+    SDL_SetRenderViewport(renderer, &(SDL_Rect) { 0, 0, w, h });
+    return;
+  }
+  if (!scaling(v->mode)) return;
+
+  float ds = window->display_scale;
+  float scale = v->pixel_scale > 0 ? v->pixel_scale : ds;
+  int w = (int) ceilf(v->width * scale);
+  int h = (int) ceilf(v->height * scale);
+  if (w < 1 || h < 1) return;
+
+  // Create the target, or create it again at a new size
+  if (!target || target->w != w || target->h != h) {
+    if (target) SDL_DestroyTexture(target);
+    target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (!target) {
+      S2D_Error("SDL_CreateTexture", SDL_GetError());
+      return;
+    }
+    SDL_SetTextureBlendMode(target, SDL_BLENDMODE_NONE);
+    S2D_Log(S2D_INFO, "Drawing viewport at %dx%d", w, h);
+  }
+
+  if (!SDL_SetRenderTarget(renderer, target)) {
+    S2D_Error("SDL_SetRenderTarget", SDL_GetError());
+    return;
+  }
+
+  // Draw in the usual renderer coordinates, scaled to the internal resolution
+  render_scale = scale / ds;
+  SDL_SetRenderScale(renderer, render_scale, render_scale);
+  using_target = true;
+}
+
+
+/*
+ * End drawing a frame in the viewport, scaling the target to the window with
+ * black bars where the aspect ratio differs
+ */
+void S2D_EndViewportFrame() {
+  SDL_Renderer *renderer = s2d_app.window->sdl_renderer;
+  if (s2d_app.window->viewport.mode == S2D_FIXED) SDL_SetRenderViewport(renderer, NULL);
+  if (!using_target) return;
+  using_target = false;
+
+  SDL_SetRenderTarget(renderer, NULL);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+  SDL_RenderClear(renderer);
+
+  int output_w, output_h;
+  if (!SDL_GetRenderOutputSize(renderer, &output_w, &output_h)) return;
+  SDL_FRect dst = present_rect(output_w, output_h);
+  SDL_RenderTexture(renderer, target, NULL, &dst);
+}
+
+
+/*
+ * Recreate the viewport's target if it was lost with the renderer's device
+ */
+void S2D_InvalidateViewport(bool textures_lost) {
+  if (textures_lost && target) {
+    SDL_DestroyTexture(target);
+    target = NULL;
+  }
+}
+
+
+/*
+ * Free the viewport's target when quitting
+ */
+void S2D_FreeViewport() {
+  if (target) SDL_DestroyTexture(target);
+  target = NULL;
+}
@@ -2,6 +2,14 @@
 
 #include "../include/simple2d.h"
 
+// On-demand rendering, where frames are drawn only when something changed
+static bool on_demand = false;
+static bool animating = false;
+static bool keys_held = false;   // held keys are dispatched every frame
+static SDL_AtomicInt redraw;      // a frame was requested
+static Uint32 redraw_event = 0;   // pushed to wake the main loop for a request
+static uint64_t skipped = 0;      // iterations without a frame
+
 
 /*
  * Map window to renderer coordinates
@@ -35,6 +43,12 @@ S2D_Window *S2D_CreateWindow(const char *title, int width, int height) {
   window->title = title;
   window->width = width;
   window->height = height;
+  window->orig_width = width;
+  window->orig_height = height;
+  window->viewport.width = width;
+  window->viewport.height = height;
+  window->viewport.mode = S2D_EXPAND;
+  window->viewport.pixel_scale = 0;
   window->flags |= SDL_WINDOW_HIGH_PIXEL_DENSITY;
   window->background.r = 0.0;
   window->background.g = 0.0;
@@ -68,12 +82,6 @@ S2D_Window *S2D_CreateWindow(const char *title, int width, int height) {
   S2D_Log(S2D_INFO, "  display_scale: %.2f", display_scale);
   S2D_Log(S2D_INFO, "  refresh_rate: %.2f", mode->refresh_rate);
 
-  // Set the main callback rate to the display's refresh rate
-  // VSync will cap FPS, but this is needed if window is occluded so it doesn't run infinitely fast
-  char refresh_rate_str[16];
-  snprintf(refresh_rate_str, sizeof(refresh_rate_str), "%d", (int)mode->refresh_rate);
-  SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, refresh_rate_str);
-
   window->display_width = mode->w;
   window->display_height = mode->h;
   window->display_scale = display_scale;
@@ -83,14 +91,181 @@ S2D_Window *S2D_CreateWindow(const char *title, int width, int height) {
   SDL_free(display_id);
 
   s2d_app.window = window;
+  S2D_UpdateCallbackRate();
   return window;
 }
 
 
+/*
+ * Returns true if any key is held down
+ */
+static bool any_key_held() {
+  int num_keys;
+  const bool *key_state = SDL_GetKeyboardState(&num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    if (key_state[i]) return true;
+  }
+  return false;
+}
+
+
+/*
+ * Set the main callback rate to the display's refresh rate. VSync will cap
+ * FPS, but this is needed if the window is occluded so it doesn't run
+ * infinitely fast, and it's slower while the window is hidden. When rendering
+ * on demand and not animating or holding keys, wait for events instead. When
+ * headless, run unthrottled so replayed sessions can be benchmarked.
+ */
+void S2D_UpdateCallbackRate() {
+  S2D_Window *window = s2d_app.window;
+  char rate[16];
+  if (s2d_app.headless) {
+    snprintf(rate, sizeof(rate), "0");
+  } else if (on_demand && ((!animating && !keys_held) || window->hidden)) {
+    snprintf(rate, sizeof(rate), "waitevent");
+  } else if (window->hidden) {
+    snprintf(rate, sizeof(rate), "%d", S2D_HIDDEN_CALLBACK_RATE);
+  } else {
+    snprintf(rate, sizeof(rate), "%d", (int)window->display_refresh_rate);
+  }
+  SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, rate);
+}
+
+
+/*
+ * Enable or disable on-demand rendering, where frames are drawn only after
+ * input and window events, `S2D_RequestRedraw()`, or while animating, and the
+ * app otherwise waits for events
+ */
+void S2D_EnableOnDemandRendering(bool status) {
+  on_demand = status;
+  if (on_demand && redraw_event == 0) redraw_event = SDL_RegisterEvents(1);
+  SDL_SetAtomicInt(&redraw, 1);
+  S2D_UpdateCallbackRate();
+}
+
+
+/*
+ * Request a frame when rendering on demand, like when content changes outside
+ * of input events. Can be called from any thread.
+ */
+void S2D_RequestRedraw() {
+  if (!SDL_CompareAndSwapAtomicInt(&redraw, 0, 1)) return;
+
+  // Wake the main loop if it's waiting for events
+  if (on_demand && redraw_event != 0) {
+    SDL_Event event;
+    memset(&event, 0, sizeof(SDL_Event));
+    event.type = redraw_event;
+    SDL_PushEvent(&event);
+  }
+}
+
+
+/*
+ * Draw every frame while animating, even when rendering on demand
+ */
+void S2D_SetAnimating(bool status) {
+  animating = status;
+  S2D_UpdateCallbackRate();
+}
+
+
+/*
+ * Request a frame for an event, and track whether the window is hidden
+ * (minimized, occluded, or hidden), slowing the callback rate while it is,
+ * and whether keys are held, drawing every frame while they are
+ */
+void S2D_HandleRedrawEvent(const SDL_Event *event) {
+  S2D_Window *window = s2d_app.window;
+  bool hidden = window->hidden;
+
+  switch (event->type) {
+    case SDL_EVENT_WINDOW_MINIMIZED:
+    case SDL_EVENT_WINDOW_OCCLUDED:
+    case SDL_EVENT_WINDOW_HIDDEN:
+      hidden = true;
+      break;
+    case SDL_EVENT_WINDOW_RESTORED:
+    case SDL_EVENT_WINDOW_MAXIMIZED:
+    case SDL_EVENT_WINDOW_EXPOSED:
+    case SDL_EVENT_WINDOW_SHOWN:
+      hidden = false;
+      break;
+  }
+  if (hidden != window->hidden) {
+    window->hidden = hidden;
+    S2D_Log(S2D_INFO, hidden ? "Window hidden, throttling frames" : "Window shown");
+    S2D_UpdateCallbackRate();
+  }
+
+  switch (event->type) {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+    case SDL_EVENT_WINDOW_FOCUS_LOST: {
+      bool held = any_key_held();
+      if (held != keys_held) {
+        keys_held = held;
+        S2D_UpdateCallbackRate();
+      }
+      break;
+    }
+  }
+
+  // The frame follows the event, so there's no need to wake the main loop
+  if (event->type != redraw_event) SDL_SetAtomicInt(&redraw, 1);
+}
+
+
+/*
+ * Returns true if a frame should be drawn, which is always unless rendering
+ * on demand, where it's when requested, while animating or replaying input,
+ * or while keys are held
+ */
+bool S2D_ShouldRender() {
+  if (!on_demand || animating || S2D_IsReplaying()) return true;
+  if (SDL_CompareAndSwapAtomicInt(&redraw, 1, 0)) return true;
+  if (any_key_held()) return true;
+
+  skipped++;
+  return false;
+}
+
+
+/*
+ * End a frame when rendering on demand, requesting another if a texture upload
+ * was deferred or a layer is still dirty, so pending work doesn't wait for input
+ */
+void S2D_EndRedrawFrame() {
+  if (!on_demand) return;
+  bool pending = S2D_UploadsDeferred();
+
+  int count;
+  S2D_Layer *const *layers = S2D_GetLiveLayers(&count);
+  for (int i = 0; i < count && !pending; i++) {
+    if (layers[i]->dirty) pending = true;
+  }
+
+  if (pending) S2D_RequestRedraw();
+}
+
+
+/*
+ * Get the number of main loop iterations without a frame, when rendering on demand
+ */
+uint64_t S2D_GetSkippedFrames() {
+  return skipped;
+}
+
+
 /*
  * Show the window by creating the SDL window and renderer, and enabling VSync
+ * (unless running headless). Does nothing if already shown, like by apps that
+ * need the renderer in `S2D_Init()`.
  */
 bool S2D_ShowWindow() {
+  if (s2d_app.window->sdl_renderer) return true;
+
   // Scale window dimensions by content_scale so the window appears at the
   // correct logical size on all platforms. On macOS, content_scale is 1.0
   // (window coords are already in points). On Windows, content_scale matches
@@ -107,8 +282,10 @@ bool S2D_ShowWindow() {
   }
 
   SDL_SetRenderDrawBlendMode(s2d_app.window->sdl_renderer, SDL_BLENDMODE_BLEND);
+  S2D_UpdateViewport();  // map the mouse to the viewport before the first frame
+  S2D_RememberTextureCacheFormat();
 
-  if (!SDL_SetRenderVSync(s2d_app.window->sdl_renderer, 1)) {
+  if (!s2d_app.headless && !SDL_SetRenderVSync(s2d_app.window->sdl_renderer, 1)) {
     S2D_Error("S2D_ShowWindow / SDL_SetRenderVSync", SDL_GetError());
     return false;
   }
@@ -11,12 +11,14 @@ void start_test_suite() {
 }
 
 void start_test(char *test) {
+  S2D_FlushLog();  // keep log messages in order with test output
   printf("\033[1;34m==>\033[1;39m Running test\033[0m %s\n", test);
   tests++;
 }
 
 // Improved: Accepts a message for failed tests for better output consistency
 void end_test(TestStatus status, const char *fail_msg) {
+  S2D_FlushLog();
   if (status == TEST_FAIL) {
     failures++;
     printf("\033[1;31m==> Test failed: %s\033[0m\n", fail_msg);
@@ -33,6 +35,21 @@ void end_test_suite() {
 }
 
 
+// Input events delivered to the handlers, with the frame each arrived on
+S2D_Event captured[8];
+uint64_t captured_frames[8];
+int captured_count = 0;
+
+void capture_event(S2D_Event e) {
+  if (captured_count == 8) return;
+  captured_frames[captured_count] = s2d_app.window->frames;
+  captured[captured_count++] = e;
+}
+
+void S2D_OnKey(S2D_Event e) { capture_event(e); }
+void S2D_OnMouse(S2D_Event e) { capture_event(e); }
+
+
 void S2D_Init() {
 
   // Set Up ////////////////////////////////////////////////////////////////////
@@ -40,6 +57,7 @@ void S2D_Init() {
   S2D_Windows_EnableTerminalColors();
   start_test_suite();
   S2D_CreateWindow("Simple 2D", 640, 480);
+  S2D_ShowWindow();  // create the renderer now, for tests that upload textures
 
   // Logging ///////////////////////////////////////////////////////////////////
   // Test: Logging info, warning, and error messages
@@ -50,6 +68,109 @@ void S2D_Init() {
   S2D_Error("S2D_Error", "An error message");
   end_test(TEST_PASS, "");
 
+  // Test: Messages repeated from one call site are limited each second
+  start_test("(S2D_SetLogRateLimit) limit repeated messages");
+  S2D_LogStats log_before, log_after;
+  S2D_GetLogStats(&log_before);
+  Uint64 into_window = SDL_GetTicksNS() % 1000000000;  // keep the burst in one window
+  if (into_window > 900000000) SDL_DelayNS(1000000000 - into_window);
+  S2D_SetLogRateLimit(2);
+  for (int i = 0; i < 5; i++) S2D_Log(S2D_WARN, "(S2D_Log) Repeated message %d", i);
+  S2D_SetLogRateLimit(0);
+  S2D_FlushLog();
+  S2D_GetLogStats(&log_after);
+  end_test((log_after.suppressed - log_before.suppressed >= 3 &&
+            log_after.written - log_before.written <= 2) ? TEST_PASS : TEST_FAIL,
+           "Repeated messages were not rate limited");
+
+  // Frame Arena ///////////////////////////////////////////////////////////////
+  // Test: Allocate aligned transient memory and formatted strings
+  start_test("(S2D_FrameAlloc) allocate from the frame arena");
+  void *block1 = S2D_FrameAlloc(3);
+  void *block2 = S2D_FrameAlloc(64);
+  char *formatted = S2D_FrameFormat("%s %d", "frame", 42);
+  S2D_FrameArenaStats arena_stats;
+  S2D_GetFrameArenaStats(&arena_stats);
+  end_test((block1 && block2 && ((uintptr_t)block2 % 16) == 0 &&
+            formatted && strcmp(formatted, "frame 42") == 0 &&
+            arena_stats.used >= 80 && arena_stats.high_water >= arena_stats.used) ? TEST_PASS : TEST_FAIL,
+           "Frame arena allocations were not aligned or formatted");
+  S2D_ResetFrameArena();
+
+  // Asset Packs ///////////////////////////////////////////////////////////////
+  // Test: Mount a file that isn't an asset pack (expect errors)
+  start_test("(S2D_MountPack) bad asset pack (expect errors)");
+  bool mounted_bad = S2D_MountPack("media/image.png");
+  bool mounted_missing = S2D_MountPack("media/missing.pak");
+  end_test((!mounted_bad && !mounted_missing && S2D_AssetExists("media/image.png") &&
+            !S2D_FindPackAsset("media/image.png", NULL, NULL)) ? TEST_PASS : TEST_FAIL,
+           "Bad asset packs were mounted");
+
+  // Test: Load an image, font, and audio from a pack built by `make run_auto`
+  start_test("(S2D_MountPack) load assets from an asset pack");
+  bool mounted = S2D_MountPack("auto.pak");
+  S2D_Image *packed_img = S2D_CreateImage("packed/image.png");
+  S2D_Text *packed_txt = S2D_CreateText("packed/vera.ttf", "Packed", 20);
+  S2D_Audio *packed_snd = S2D_CreateSound("packed/sound.wav");
+  end_test((mounted && S2D_FindPackAsset("packed/image.png", NULL, NULL) && !S2D_FileExists("packed/image.png") &&
+            packed_img != NULL && packed_txt != NULL && packed_snd != NULL) ? TEST_PASS : TEST_FAIL,
+           "Assets were not loaded from the pack");
+  S2D_FreeImage(packed_img); S2D_FreeText(packed_txt); S2D_FreeAudio(packed_snd);
+
+  // Startup Profile ///////////////////////////////////////////////////////////
+  // Test: Phases of startup and asset creation are timed until the first frame
+  start_test("(S2D_GetStartupPhases) time startup phases before the first frame");
+  S2D_Image *startup_img = S2D_CreateImage("media/image.png");
+  const S2D_StartupPhase *startup_phases;
+  int startup_count = S2D_GetStartupPhases(&startup_phases);
+  end_test((startup_img && startup_count >= 3 &&
+            strcmp(startup_phases[0].name, "Command line arguments") == 0 &&
+            strcmp(startup_phases[startup_count - 1].name, "S2D_CreateImage(\"media/image.png\")") == 0 &&
+            startup_phases[startup_count - 1].depth == 1 && S2D_GetTimeToFirstFrame() == 0) ? TEST_PASS : TEST_FAIL,
+           "Startup phases were not recorded");
+  S2D_FreeImage(startup_img);
+
+  // Profiling Zones ///////////////////////////////////////////////////////////
+  // Test: Nested and scoped zones are aggregated per frame
+  start_test("(S2D_ProfileBegin, S2D_PROFILE_SCOPE) aggregate nested zones");
+  S2D_EnableProfiler(true);
+  for (int i = 0; i < 2; i++) {
+    S2D_PROFILE_SCOPE("auto outer");
+    S2D_ProfileBegin("auto inner");
+    S2D_ProfileEnd();
+  }
+  S2D_EndProfileFrame();
+  const S2D_ProfileZone *profile_zones;
+  int profile_count = S2D_GetProfileZones(&profile_zones);
+  bool outer_ok = false, inner_ok = false;
+  for (int i = 0; i < profile_count; i++) {
+    const S2D_ProfileZone *z = &profile_zones[i];
+    if (strcmp(z->name, "auto outer") == 0) outer_ok = z->calls == 2 && z->depth == 0;
+    if (strcmp(z->name, "auto inner") == 0) inner_ok = z->calls == 2 && z->depth == 1 && z->ms >= 0;
+  }
+  end_test((outer_ok && inner_ok) ? TEST_PASS : TEST_FAIL, "Profiling zones were not aggregated");
+  S2D_ResetProfiler();
+  S2D_EnableProfiler(false);
+
+  // Tracing ///////////////////////////////////////////////////////////////////
+  // Test: Record asset loads and write them as Chrome trace JSON
+  start_test("(S2D_StartTrace) write a trace of asset loads");
+  bool trace_started = S2D_StartTrace("auto.trace.json");
+  S2D_Image *trace_img = S2D_CreateImage("media/image.png");
+  bool trace_stopped = S2D_StopTrace();
+  char trace_json[4096] = "";
+  FILE *trace_file = fopen("auto.trace.json", "r");
+  if (trace_file) {
+    trace_json[fread(trace_json, 1, sizeof(trace_json) - 1, trace_file)] = '\0';
+    fclose(trace_file);
+  }
+  end_test((trace_started && trace_stopped && !S2D_IsTracing() &&
+            strstr(trace_json, "\"traceEvents\"") && strstr(trace_json, "\"S2D_CreateImage\"") &&
+            strstr(trace_json, "media/image.png")) ? TEST_PASS : TEST_FAIL,
+           "Trace file was not written with the asset load");
+  S2D_FreeImage(trace_img);
+  remove("auto.trace.json");
+
   // Images ////////////////////////////////////////////////////////////////////
   // Test: Create images with supported formats
   start_test("(S2D_CreateImage) create images with supported formats");
@@ -59,6 +180,38 @@ void S2D_Init() {
   end_test((img1 != NULL && img2 != NULL && img3 != NULL) ? TEST_PASS : TEST_FAIL,
            "Failed to create images with supported formats");
 
+  // Test: Preload a texture, and defer uploads past the per-frame budget
+  start_test("(S2D_PreloadImage, S2D_SetUploadBudget) preload and defer texture uploads");
+  S2D_UploadStats upload_before, upload_after;
+  S2D_GetUploadStats(&upload_before);
+  SDL_Renderer *shown_renderer = s2d_app.window->sdl_renderer;
+  s2d_app.window->sdl_renderer = NULL;  // like in `S2D_Init()` before the window is shown
+  bool waited = !S2D_PreloadImage(img1) && !img1->texture;
+  s2d_app.window->sdl_renderer = shown_renderer;
+  bool preloaded = S2D_PreloadImage(img1) && img1->texture && !img1->surface;
+  S2D_ResetUploadBudget();
+  S2D_SetUploadBudget(0, 1);
+  S2D_DrawImage(img2);  // the first upload of a frame always fits
+  S2D_DrawImage(img3);  // deferred, drawing a placeholder
+  bool deferred = img2->texture && !img3->texture && img3->surface;
+  S2D_SetUploadBudget(0, 0);
+  S2D_ResetUploadBudget();
+  S2D_GetUploadStats(&upload_after);
+  end_test((waited && preloaded && deferred && upload_after.preloads == upload_before.preloads + 1 &&
+            upload_after.deferred == upload_before.deferred + 1 &&
+            upload_after.frame_deferred == 1) ? TEST_PASS : TEST_FAIL,
+           "Textures were not preloaded, or uploads were not deferred by the budget");
+
+  // Test: Account for the memory used by live images
+  start_test("(S2D_GetMemoryStats) account for image memory");
+  S2D_MemoryStats memory;
+  S2D_GetMemoryStats(&memory);
+  S2D_DumpMemory(stdout, 5);
+  end_test((memory.image_surfaces.count + memory.image_textures.count >= 3 &&
+            memory.image_textures.bytes > 0 && memory.pools > 0 &&
+            memory.total >= memory.image_surfaces.bytes + memory.image_textures.bytes) ? TEST_PASS : TEST_FAIL,
+           "Image memory was not accounted for");
+
   // Test: Create images with bad file paths (expect errors)
   start_test("(S2D_CreateImage) bad image file path (expect errors)");
   S2D_Image *img4 = S2D_CreateImage("image.bmp");
@@ -67,6 +220,30 @@ void S2D_Init() {
   end_test((img4 == NULL && img5 == NULL && img6 == NULL) ? TEST_PASS : TEST_FAIL,
            "Bad image file paths did not return NULL as expected");
 
+  // Test: Images with the same path share an interned path, and reuse pooled memory
+  start_test("(S2D_CreateImage) share interned paths and reuse pooled structures");
+  S2D_Image *img7 = S2D_CreateImage("media/image.png");
+  bool shared_path = img7 && img7->path == img3->path;
+  S2D_FreeImage(img7);
+  S2D_Image *img8 = S2D_CreateImage("media/image.png");
+  end_test((shared_path && img8 == img7) ? TEST_PASS : TEST_FAIL,
+           "Image paths were not interned, or the freed image was not reused");
+  S2D_FreeImage(img8);
+
+  // Test: Decoded images are stored in the texture cache, then loaded from it
+  start_test("(S2D_EnableTextureCache) store and load decoded images");
+  S2D_EnableTextureCache("texcache");
+  S2D_TextureCacheStats tex_before, tex_after;
+  S2D_GetTextureCacheStats(&tex_before);
+  S2D_Image *img9 = S2D_CreateImage("media/image.png");
+  S2D_Image *img10 = S2D_CreateImage("media/image.png");
+  S2D_GetTextureCacheStats(&tex_after);
+  end_test((img9 && img10 && img9->width == img10->width && img9->height == img10->height &&
+            tex_after.hits >= tex_before.hits + 1) ? TEST_PASS : TEST_FAIL,
+           "Decoded image was not loaded from the texture cache");
+  S2D_FreeImage(img9); S2D_FreeImage(img10);
+  S2D_EnableTextureCache(NULL);
+
   // Test: Free images
   start_test("(S2D_FreeImage) free images");
   S2D_FreeImage(img1); S2D_FreeImage(img2); S2D_FreeImage(img3);
@@ -144,6 +321,15 @@ void S2D_Init() {
   end_test((txt1 != NULL) ? TEST_PASS : TEST_FAIL,
            "Failed to set text to empty or NULL");
 
+  // Test: Set text from its own message, growing its buffer
+  start_test("(S2D_SetText) format text from its own message");
+  S2D_SetText(txt2, "Hello");
+  S2D_SetText(txt2, txt2->msg);
+  bool same_msg = strcmp(txt2->msg, "Hello") == 0;
+  S2D_SetText(txt2, "%s, %s! A much longer message than before", txt2->msg, txt2->msg);
+  end_test((same_msg && strcmp(txt2->msg, "Hello, Hello! A much longer message than before") == 0) ? TEST_PASS : TEST_FAIL,
+           "Text set from its own message was not formatted correctly");
+
   // Test: Free text
   start_test("(S2D_FreeText) free text");
   S2D_FreeText(txt1); S2D_FreeText(txt2); S2D_FreeText(txt3);
@@ -156,6 +342,138 @@ void S2D_Init() {
   S2D_FreeText(NULL);
   end_test(TEST_PASS, "");
 
+  // Layers ////////////////////////////////////////////////////////////////////
+  // Test: Layers are drawn only when dirty, and accounted for in memory
+  start_test("(S2D_BeginLayer) draw layer content only when dirty");
+  S2D_Layer *layer = S2D_CreateLayer(100, 50);
+  bool first_draw = S2D_BeginLayer(layer);
+  if (first_draw) {
+    S2D_DrawQuad(0, 0, 1, 0, 0, 1, 100, 0, 1, 0, 0, 1, 100, 50, 1, 0, 0, 1, 0, 50, 1, 0, 0, 1);
+    S2D_EndLayer(layer);
+  }
+  bool cached = !S2D_BeginLayer(layer);
+  S2D_InvalidateLayer(layer);
+  bool redrawn = S2D_BeginLayer(layer);
+  if (redrawn) S2D_EndLayer(layer);
+  S2D_DrawLayer(layer);
+  S2D_GetMemoryStats(&memory);
+  end_test((first_draw && cached && redrawn && layer->redraws == 2 && !layer->dirty &&
+            memory.layers.count == 1 && memory.layers.bytes > 0) ? TEST_PASS : TEST_FAIL,
+           "Layer content was not cached until invalidated");
+  S2D_FreeLayer(layer);
+
+  // Dirty Rectangles //////////////////////////////////////////////////////////
+  // Test: Draw everything on the first frame, nothing when unchanged, then only a moved quad
+  start_test("(S2D_EnableDirtyRects) draw again only regions that changed");
+  S2D_DirtyRectStats dirty[3];
+  S2D_EnableDirtyRects(true);
+  for (int frame = 0; frame < 3; frame++) {
+    float x = frame == 2 ? 30 : 10;
+    bool began = S2D_BeginDirtyFrame();
+    S2D_DrawQuad(x, 10, 1, 1, 1, 1, x + 10, 10, 1, 1, 1, 1, x + 10, 20, 1, 1, 1, 1, x, 20, 1, 1, 1, 1);
+    if (began) S2D_EndDirtyFrame();
+    S2D_GetDirtyRectStats(&dirty[frame]);
+  }
+  S2D_EnableDirtyRects(false);
+  end_test((dirty[0].full_redraws == 1 && dirty[1].rects == 0 && dirty[1].replayed == 0 &&
+            dirty[2].rects == 2 && dirty[2].replayed == 1 && dirty[2].full_redraws == 1 &&
+            dirty[2].damaged < 0.1f) ? TEST_PASS : TEST_FAIL,
+           "Unchanged regions were drawn again, or changed ones were not");
+
+  // On-Demand Rendering ///////////////////////////////////////////////////////
+  // Test: Frames are drawn only when requested or animating
+  start_test("(S2D_EnableOnDemandRendering) draw frames only when needed");
+  uint64_t skipped = S2D_GetSkippedFrames();
+  S2D_EnableOnDemandRendering(true);
+  bool initial = S2D_ShouldRender();
+  bool idle = !S2D_ShouldRender();
+  S2D_RequestRedraw();
+  bool requested = S2D_ShouldRender();
+  S2D_SetAnimating(true);
+  bool animated = S2D_ShouldRender() && S2D_ShouldRender();
+  S2D_SetAnimating(false);
+  S2D_EnableOnDemandRendering(false);
+  end_test((initial && idle && requested && animated && S2D_ShouldRender() &&
+            S2D_GetSkippedFrames() == skipped + 1) ? TEST_PASS : TEST_FAIL,
+           "Frames were not drawn only when needed");
+
+  // Test: A deferred upload draws another frame without waiting for input
+  start_test("(S2D_EndRedrawFrame) draw again for deferred uploads on demand");
+  S2D_Image *ondemand_img1 = S2D_CreateImage("media/image.png");
+  S2D_Image *ondemand_img2 = S2D_CreateImage("media/image.bmp");
+  S2D_EnableOnDemandRendering(true);
+  S2D_ShouldRender();  // the first frame
+  S2D_SetUploadBudget(0, 1);
+  S2D_ResetUploadBudget();
+  S2D_DrawImage(ondemand_img1);
+  S2D_DrawImage(ondemand_img2);  // deferred
+  S2D_EndRedrawFrame();
+  bool pending = S2D_ShouldRender();
+  S2D_ResetUploadBudget();
+  S2D_DrawImage(ondemand_img2);
+  S2D_EndRedrawFrame();
+  bool finished = ondemand_img2->texture && !S2D_ShouldRender();
+  S2D_SetUploadBudget(0, 0);
+  S2D_EnableOnDemandRendering(false);
+  end_test((pending && finished) ? TEST_PASS : TEST_FAIL,
+           "A deferred upload waited for input, or frames were drawn after it finished");
+  S2D_FreeImage(ondemand_img1); S2D_FreeImage(ondemand_img2);
+
+  // Viewport //////////////////////////////////////////////////////////////////
+  // Test: Draw a scaled viewport at half resolution, mapping the mouse to it
+  start_test("(S2D_SCALE) draw the viewport at an internal resolution");
+  s2d_app.window->viewport.mode = S2D_SCALE;
+  s2d_app.window->viewport.pixel_scale = 0.5;
+  S2D_BeginViewportFrame();
+  SDL_Texture *viewport_target = S2D_GetViewportTarget();
+  S2D_DrawQuad(0, 0, 1, 1, 1, 1, 640, 0, 1, 1, 1, 1, 640, 480, 1, 1, 1, 1, 0, 480, 1, 1, 1, 1);
+  S2D_EndViewportFrame();
+  float center_x = 320 * s2d_app.window->display_content_scale;
+  float center_y = 240 * s2d_app.window->display_content_scale;
+  S2D_WindowToViewportCoordinates(&center_x, &center_y);
+  bool presented = !S2D_GetViewportTarget();
+  s2d_app.window->viewport.mode = S2D_EXPAND;
+  s2d_app.window->viewport.pixel_scale = 0;
+  S2D_UpdateViewport();
+  end_test((viewport_target && viewport_target->w == 320 && viewport_target->h == 240 && presented &&
+            fabsf(center_x - 320) < 1 && fabsf(center_y - 240) < 1) ? TEST_PASS : TEST_FAIL,
+           "The viewport was not drawn at its internal resolution, or the mouse not mapped to it");
+
+  // Test: Dirty rectangles replay at the viewport's internal resolution
+  start_test("(S2D_EnableDirtyRects) replay at the viewport's internal resolution");
+  s2d_app.window->viewport.mode = S2D_SCALE;
+  s2d_app.window->viewport.pixel_scale = 0.5;
+  S2D_EnableDirtyRects(true);
+  S2D_DirtyRectStats scaled_dirty[2];
+  float scaled_render = 0;
+  for (int frame = 0; frame < 2; frame++) {
+    float x = frame == 1 ? 30 : 10;
+    S2D_BeginViewportFrame();
+    scaled_render = S2D_GetViewportRenderScale();
+    bool began = S2D_BeginDirtyFrame();
+    S2D_DrawQuad(x, 10, 1, 1, 1, 1, x + 10, 10, 1, 1, 1, 1, x + 10, 20, 1, 1, 1, 1, x, 20, 1, 1, 1, 1);
+    if (began) S2D_EndDirtyFrame();
+    S2D_EndViewportFrame();
+    S2D_GetDirtyRectStats(&scaled_dirty[frame]);
+  }
+  S2D_EnableDirtyRects(false);
+  s2d_app.window->viewport.mode = S2D_EXPAND;
+  s2d_app.window->viewport.pixel_scale = 0;
+  S2D_UpdateViewport();
+  end_test((fabsf(scaled_render - 0.5f / s2d_app.window->display_scale) < 0.001f &&
+            scaled_dirty[1].full_redraws == scaled_dirty[0].full_redraws &&
+            scaled_dirty[1].replayed == 1 && scaled_dirty[1].damaged < 0.1f) ? TEST_PASS : TEST_FAIL,
+           "Dirty rectangles were not replayed at the viewport's internal resolution");
+
+  // Subsystems ////////////////////////////////////////////////////////////////
+  // Test: Text started its subsystem on first use, audio and controllers not yet
+  start_test("(S2D_GetStartedSubsystems) start subsystems on first use");
+  S2D_GetControllerAxis(-1, S2D_AXIS_LEFTX);  // querying a missing controller starts nothing
+  int subsystems = S2D_GetStartedSubsystems();
+  end_test(((subsystems & S2D_SUBSYSTEM_TEXT) && !(subsystems & S2D_SUBSYSTEM_AUDIO) &&
+            !(subsystems & S2D_SUBSYSTEM_CONTROLLERS)) ? TEST_PASS : TEST_FAIL,
+           "Subsystems were not started on first use");
+
   // Audio /////////////////////////////////////////////////////////////////////
   // Test: Create audio with supported formats
   start_test("(S2D_CreateAudio) create audio with supported formats");
@@ -166,6 +484,112 @@ void S2D_Init() {
   end_test((aud1 != NULL && aud2 != NULL && aud3 != NULL && aud4 != NULL) ? TEST_PASS : TEST_FAIL,
            "Failed to create audio with supported formats");
 
+  // Test: Create predecoded sounds and streamed music
+  start_test("(S2D_CreateSound, S2D_CreateMusic) create predecoded and streamed audio");
+  S2D_Audio *snd1 = S2D_CreateSound("media/sound.wav");
+  S2D_Audio *mus1 = S2D_CreateMusic("media/music.ogg");
+  end_test((snd1 != NULL && mus1 != NULL && snd1->predecoded && !mus1->predecoded &&
+            S2D_GetAudioDecodedBytes(snd1) > 0 && S2D_GetAudioDecodedBytes(mus1) == 0 &&
+            S2D_GetTotalAudioDecodedBytes() >= S2D_GetAudioDecodedBytes(snd1)) ? TEST_PASS : TEST_FAIL,
+           "Failed to create predecoded and streamed audio");
+  S2D_FreeAudio(snd1); S2D_FreeAudio(mus1);
+
+  // Test: Audio with the same path shares cached data
+  start_test("(S2D_CreateSound) share cached audio data");
+  S2D_Audio *snd2 = S2D_CreateSound("media/sound.wav");
+  S2D_Audio *snd3 = S2D_CreateSound("media/sound.wav");
+  end_test((snd2 != NULL && snd3 != NULL && snd2->data == snd3->data && snd2->data->refs == 2) ? TEST_PASS : TEST_FAIL,
+           "Audio with the same path did not share cached data");
+  S2D_FreeAudio(snd2); S2D_FreeAudio(snd3);
+
+  // Test: Evict unreferenced audio data to fit the cache budget
+  start_test("(S2D_SetAudioCacheBudget) evict unreferenced audio data");
+  S2D_SetAudioCacheBudget(0);
+  S2D_AudioCacheStats cache_stats;
+  S2D_GetAudioCacheStats(&cache_stats);
+  end_test((cache_stats.entries == cache_stats.referenced) ? TEST_PASS : TEST_FAIL,
+           "Unreferenced audio data was not evicted");
+  S2D_SetAudioCacheBudget(S2D_AUDIO_CACHE_BUDGET);
+
+  // Test: Streamed audio is charged its loaded size, so it's evicted too
+  start_test("(S2D_SetAudioCacheBudget) evict unreferenced streamed audio");
+  S2D_Audio *mus2 = S2D_CreateMusic("media/music.ogg");
+  bool charged = mus2 != NULL && mus2->data->bytes > 0;
+  S2D_FreeAudio(mus2);
+  S2D_GetAudioCacheStats(&cache_stats);
+  uint64_t evictions = cache_stats.evictions;
+  S2D_SetAudioCacheBudget(0);
+  S2D_GetAudioCacheStats(&cache_stats);
+  end_test((charged && cache_stats.evictions == evictions + 1 && cache_stats.entries == cache_stats.referenced) ? TEST_PASS : TEST_FAIL,
+           "Unreferenced streamed audio was not evicted");
+  S2D_SetAudioCacheBudget(S2D_AUDIO_CACHE_BUDGET);
+
+  // Test: Streamed audio counts toward memory usage
+  start_test("(S2D_GetMemoryStats) account for streamed audio memory");
+  S2D_Audio *mus3 = S2D_CreateMusic("media/music.ogg");
+  S2D_GetMemoryStats(&memory);
+  end_test((mus3 != NULL && mus3->data->bytes > 0 && memory.audio.bytes >= mus3->data->bytes) ? TEST_PASS : TEST_FAIL,
+           "Streamed audio was not counted in memory usage");
+  S2D_FreeAudio(mus3);
+
+  // Test: Schedule a sound on the audio clock, then cancel it
+  start_test("(S2D_PlayAudioAt) schedule and cancel audio");
+  S2D_Audio *snd4 = S2D_CreateSound("media/sound.wav");
+  int64_t at = S2D_GetAudioClock() + S2D_AudioMSToFrames(1000);
+  bool scheduled = S2D_PlayAudioAt(snd4, at);
+  S2D_AudioVoiceStats voice_stats;
+  S2D_GetAudioVoiceStats(&voice_stats);
+  int scheduled_active = voice_stats.active;
+  S2D_StopAudio(snd4, 0);
+  S2D_GetAudioVoiceStats(&voice_stats);
+  end_test((scheduled && scheduled_active >= 1 && voice_stats.active == 0) ? TEST_PASS : TEST_FAIL,
+           "Scheduled audio was not reserved or cancelled");
+  S2D_FreeAudio(snd4);
+
+  // Test: A single-voice sound plays one instance, whether scheduled or not
+  start_test("(S2D_PlayAudioAt) keep a single-voice sound to one instance");
+  S2D_Audio *single_snd = S2D_CreateSound("media/sound.wav");
+  S2D_PlayAudio(single_snd);
+  bool own_playing = MIX_TrackPlaying(single_snd->mix_track);
+  S2D_PlayAudioAt(single_snd, S2D_GetAudioClock() + S2D_AudioMSToFrames(1000));
+  bool own_replaced = !MIX_TrackPlaying(single_snd->mix_track);
+  S2D_PlayAudio(single_snd);
+  S2D_GetAudioVoiceStats(&voice_stats);
+  end_test((own_playing && own_replaced && voice_stats.active == 0 &&
+            MIX_TrackPlaying(single_snd->mix_track)) ? TEST_PASS : TEST_FAIL,
+           "A single-voice sound played more than one instance");
+  S2D_StopAudio(single_snd, 0);
+  S2D_FreeAudio(single_snd);
+
+  // Test: Polyphonic audio fills the voice pool, then steals by priority
+  start_test("(S2D_SetAudioVoices) play on pooled voices and steal by priority");
+  S2D_Audio *low = S2D_CreateSound("media/sound.wav");
+  S2D_Audio *high = S2D_CreateSound("media/sound.wav");
+  S2D_SetAudioVoices(low, S2D_AUDIO_VOICES, 0);
+  S2D_SetAudioVoices(high, 2, 1);
+  S2D_AudioVoiceStats pool_before, pool_full, pool_after;
+  S2D_GetAudioVoiceStats(&pool_before);
+  for (int i = 0; i <= S2D_AUDIO_VOICES; i++) S2D_PlayAudio(low);  // the last restarts its own voice
+  S2D_GetAudioVoiceStats(&pool_full);
+  S2D_PlayAudio(high);  // steals a lower priority voice
+  S2D_GetAudioVoiceStats(&pool_after);
+  end_test((!low->mix_track && pool_full.active == pool_full.voices &&
+            pool_full.stolen == pool_before.stolen && pool_after.stolen == pool_before.stolen + 1) ? TEST_PASS : TEST_FAIL,
+           "Voices were not pooled or stolen as expected");
+  S2D_FreeAudio(low); S2D_FreeAudio(high);
+
+  // Test: Write to an audio stream's ring buffer until it's full
+  start_test("(S2D_WriteAudioStream) fill an audio stream ring buffer");
+  S2D_AudioStream *stream = S2D_CreateAudioStream(48000, 1, 1000, NULL, NULL);
+  float stream_samples[512] = { 0 };
+  int space = S2D_GetAudioStreamSpace(stream);
+  int written = 0;
+  for (int i = 0; i < 4; i++) written += S2D_WriteAudioStream(stream, stream_samples, 512);
+  end_test((stream != NULL && space == 1024 && written == 1024 &&
+            S2D_GetAudioStreamSpace(stream) == 0) ? TEST_PASS : TEST_FAIL,
+           "Audio stream ring buffer did not fill as expected");
+  S2D_FreeAudioStream(stream);
+
   // Test: Create audio with bad file path (expect errors)
   start_test("(S2D_CreateAudio) bad audio file path (expect errors)");
   S2D_Audio *aud5 = S2D_CreateAudio("sound.wav");
@@ -186,6 +610,110 @@ void S2D_Init() {
   S2D_FreeAudio(NULL);
   end_test(TEST_PASS, "");
 
+  // Test: Render playing audio offline, with no other audio left
+  start_test("(S2D_RenderAudio) render playing audio offline");
+  S2D_SetAudioOffline(true);  // mix audio without a device
+  S2D_EnableAudioAnalysis(true);
+  S2D_Audio *snd5 = S2D_CreateSound("media/sound.wav");
+  S2D_PlayAudio(snd5);
+  float render_buffer[1024 * 8];
+  int64_t clock_before = S2D_GetAudioClock();
+  int rendered = S2D_RenderAudio(render_buffer, 1024);
+  float render_peak = 0;
+  for (int i = 0; i < rendered * 2 && i < 1024 * 8; i++) {
+    if (fabsf(render_buffer[i]) > render_peak) render_peak = fabsf(render_buffer[i]);
+  }
+  end_test((rendered == 1024 && render_peak > 0 && S2D_GetAudioClock() == clock_before + 1024) ? TEST_PASS : TEST_FAIL,
+           "Offline rendering did not produce the mix of playing audio");
+
+  // Test: Analyze the rendered mix
+  start_test("(S2D_GetAudioAnalysis) analyze levels of the mix");
+  S2D_AudioAnalysis analysis;
+  bool analyzed = S2D_GetAudioAnalysis(&analysis);
+  end_test((analyzed && analysis.peak > 0 && analysis.rms > 0 && analysis.clock == S2D_GetAudioClock()) ? TEST_PASS : TEST_FAIL,
+           "Mixer output was not analyzed");
+  S2D_EnableAudioAnalysis(false);
+  S2D_FreeAudio(snd5);
+
+  // Test: Render to a float WAV file with the extended format and fact chunks
+  start_test("(S2D_RenderAudioToWAV) render the mix to a float WAV file");
+  bool wav_rendered = S2D_RenderAudioToWAV("auto.wav", 100);
+  unsigned char wav_header[58] = { 0 };
+  FILE *wav = fopen("auto.wav", "rb");
+  size_t wav_read = wav ? fread(wav_header, 1, sizeof(wav_header), wav) : 0;
+  if (wav) fclose(wav);
+  remove("auto.wav");
+  end_test((wav_rendered && wav_read == sizeof(wav_header) && memcmp(wav_header + 8, "WAVEfmt ", 8) == 0 &&
+            wav_header[16] == 18 && wav_header[20] == 3 && memcmp(wav_header + 38, "fact", 4) == 0 &&
+            memcmp(wav_header + 50, "data", 4) == 0) ? TEST_PASS : TEST_FAIL,
+           "The WAV file was not written with a float format and fact chunk");
+
+  // Test: Reject a render too long for a WAV file (expect errors)
+  start_test("(S2D_RenderAudioToWAV) render too long for a WAV file (expect errors)");
+  end_test(!S2D_RenderAudioToWAV("auto.wav", SDL_MAX_SINT32) ? TEST_PASS : TEST_FAIL,
+           "Rendering past the WAV size limit did not fail as expected");
+  S2D_SetAudioOffline(false);  // back to the device for later tests
+
+  // Controllers ///////////////////////////////////////////////////////////////
+  // Test: Query controller state table
+  start_test("(S2D_GetControllers) query controller state table");
+  int controller_count = 0;
+  const S2D_Controller *controllers = S2D_GetControllers(&controller_count);
+  end_test((controllers != NULL && controller_count == S2D_MAX_CONTROLLERS) ? TEST_PASS : TEST_FAIL,
+           "Controller table is missing or has the wrong size");
+
+  // Test: Query a controller that isn't connected
+  start_test("(S2D_GetController) query unknown controller");
+  end_test((S2D_GetController(-1) == NULL && S2D_GetControllerName(-1) == NULL &&
+            S2D_GetControllerAxis(-1, S2D_AXIS_LEFTX) == 0 &&
+            !S2D_GetControllerButton(-1, S2D_BUTTON_SOUTH)) ? TEST_PASS : TEST_FAIL,
+           "Unknown controller did not return empty state");
+
+  // Input Recording ///////////////////////////////////////////////////////////
+  // Test: Record input to a file, then stop recording
+  start_test("(S2D_StartRecording) record input to a file");
+  bool recording = S2D_StartRecording("auto.s2drec");
+  S2D_StopRecording();
+  end_test(recording ? TEST_PASS : TEST_FAIL, "Failed to start recording input");
+
+  // Test: Replay recorded input, delivering the same events on the same frames
+  start_test("(S2D_StartReplay) replay recorded input on the same frames");
+  uint64_t frames_before = s2d_app.window->frames;
+  captured_count = 0;
+  S2D_StartRecording("auto.s2drec");
+  S2D_DispatchEvent(S2D_ON_KEY, (S2D_Event) { .type = S2D_KEY_DOWN, .key = "A" });
+  s2d_app.window->frames++;
+  S2D_DispatchEvent(S2D_ON_MOUSE, (S2D_Event) { .type = S2D_MOUSE_DOWN, .button = S2D_MOUSE_LEFT, .x = 12, .y = 34 });
+  s2d_app.window->frames += 2;
+  S2D_DispatchEvent(S2D_ON_KEY, (S2D_Event) { .type = S2D_KEY_UP, .key = "A" });
+  S2D_StopRecording();
+  int dispatched = captured_count;
+  captured_count = 0;
+  bool replay_started = S2D_StartReplay("auto.s2drec");
+  uint64_t replay_base = s2d_app.window->frames;
+  for (int i = 0; i < 8 && S2D_IsReplaying(); i++) {
+    S2D_ReplayFrame();
+    s2d_app.window->frames++;
+  }
+  s2d_app.window->frames = frames_before;
+  s2d_app.quit = false;  // the replay closes the app when it ends
+  end_test((dispatched == 3 && replay_started && !S2D_IsReplaying() && captured_count == 3 &&
+            captured[0].type == S2D_KEY_DOWN && strcmp(captured[0].key, "A") == 0 &&
+            captured_frames[0] == replay_base &&
+            captured[1].type == S2D_MOUSE_DOWN && captured[1].button == S2D_MOUSE_LEFT &&
+            captured[1].x == 12 && captured[1].y == 34 && captured_frames[1] == replay_base + 1 &&
+            captured[2].type == S2D_KEY_UP && strcmp(captured[2].key, "A") == 0 &&
+            captured_frames[2] == replay_base + 3) ? TEST_PASS : TEST_FAIL,
+           "Replayed input did not match the recorded events and frames");
+
+  // Test: Replay a missing or invalid recording (expect errors)
+  start_test("(S2D_StartReplay) bad recording file path (expect errors)");
+  bool replay1 = S2D_StartReplay("missing.s2drec");
+  bool replay2 = S2D_StartReplay("media/image.png");
+  end_test((!replay1 && !replay2 && !S2D_IsReplaying()) ? TEST_PASS : TEST_FAIL,
+           "Bad recording files did not fail as expected");
+  remove("auto.s2drec");
+
   // Clean Up //////////////////////////////////////////////////////////////////
   end_test_suite();
   S2D_Close();
@@ -28,8 +28,8 @@ void print_help() {
 void S2D_Init() {
   window = S2D_CreateWindow("Simple 2D — Audio", 200, 150);
 
-  music = S2D_CreateAudio("media/music.ogg");
-  sound = S2D_CreateAudio("media/sound.wav");
+  music = S2D_CreateMusic("media/music.ogg");
+  sound = S2D_CreateSound("media/sound.wav");
 
   print_help();
 }
@@ -39,9 +39,11 @@ void S2D_Init() {
 
   // Change viewport scaling modes:
   //   window->viewport.mode = S2D_FIXED;
-  //   window->viewport.mode = S2D_EXPAND;
-  //   window->viewport.mode = S2D_SCALE;  // Default
+  //   window->viewport.mode = S2D_EXPAND;  // Default
+  //   window->viewport.mode = S2D_SCALE;
   //   window->viewport.mode = S2D_STRETCH;
+  // When scaling, draw fewer pixels on high-DPI displays with:
+  //   window->viewport.pixel_scale = 1.0;
 
   img_png = S2D_CreateImage("media/image.png");
   img_png->x = 300;
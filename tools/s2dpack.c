@@ -0,0 +1,239 @@
+// s2dpack.c
+// Packs asset files into a Simple 2D asset pack, mounted with `S2D_MountPack()`
+//
+// Usage: s2dpack <output.pak> <file or directory>...
+//
+// Asset paths are stored as given on the command line (directories are added
+// recursively), with backslashes converted to slashes and leading "./" removed,
+// so load assets using the same relative paths.
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// Must match the definitions in simple2d.h
+#define S2D_PACK_MAGIC "S2DPACK"
+#define S2D_PACK_VERSION 1
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t count;
+  uint64_t index_offset;
+  uint64_t names_offset;
+  uint64_t names_size;
+} S2D_PackHeader;
+
+typedef struct {
+  uint64_t hash;
+  uint64_t offset;
+  uint64_t size;
+  uint32_t name_offset;
+  uint32_t name_len;
+} S2D_PackEntry;
+
+// Alignment of each asset's data in the pack
+#define PACK_ALIGN 16
+
+// An asset to be packed
+typedef struct {
+  char *path;  // normalized
+  S2D_PackEntry entry;
+} Asset;
+
+static Asset *assets = NULL;
+static int asset_count = 0;
+static int asset_capacity = 0;
+
+
+/*
+ * Hash a normalized path using 64-bit FNV-1a, as `S2D_HashAssetPath()` does
+ */
+static uint64_t hash_path(const char *path) {
+  uint64_t hash = 14695981039346656037ull;
+  for (const char *c = path; *c; c++) {
+    hash ^= (uint8_t)*c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+
+/*
+ * Copy a path, converting backslashes to slashes and removing leading "./"
+ */
+static char *normalize_path(const char *path) {
+  while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path += 2;
+  char *norm = strdup(path);
+  for (char *c = norm; *c; c++) if (*c == '\\') *c = '/';
+  return norm;
+}
+
+
+/*
+ * Add a file to the list of assets
+ */
+static void add_file(const char *path) {
+  if (asset_count == asset_capacity) {
+    asset_capacity = asset_capacity ? asset_capacity * 2 : 64;
+    assets = (Asset *) realloc(assets, asset_capacity * sizeof(Asset));
+    if (!assets) {
+      fprintf(stderr, "Out of memory!\n");
+      exit(1);
+    }
+  }
+
+  Asset *a = &assets[asset_count++];
+  memset(a, 0, sizeof(Asset));
+  a->path = normalize_path(path);
+  a->entry.hash = hash_path(a->path);
+}
+
+
+/*
+ * Add a file, or every file in a directory recursively
+ */
+static bool add_path(const char *path) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    fprintf(stderr, "Error: `%s` not found\n", path);
+    return false;
+  }
+
+  if (!S_ISDIR(st.st_mode)) {
+    add_file(path);
+    return true;
+  }
+
+  DIR *dir = opendir(path);
+  if (!dir) {
+    fprintf(stderr, "Error: could not open directory `%s`\n", path);
+    return false;
+  }
+
+  bool ok = true;
+  struct dirent *ent;
+  while (ok && (ent = readdir(dir))) {
+    if (ent->d_name[0] == '.') continue;  // skip ".", "..", and hidden files
+    size_t len = strlen(path) + strlen(ent->d_name) + 2;
+    char *child = (char *) malloc(len);
+    snprintf(child, len, "%s/%s", path, ent->d_name);
+    ok = add_path(child);
+    free(child);
+  }
+  closedir(dir);
+  return ok;
+}
+
+
+/*
+ * Order assets by hash, then path, for binary search when mounted
+ */
+static int compare_assets(const void *a, const void *b) {
+  const Asset *x = (const Asset *) a, *y = (const Asset *) b;
+  if (x->entry.hash != y->entry.hash) return x->entry.hash < y->entry.hash ? -1 : 1;
+  return strcmp(x->path, y->path);
+}
+
+
+/*
+ * Write zero bytes until the file position is aligned
+ */
+static uint64_t pad_to(FILE *f, uint64_t pos, uint64_t align) {
+  while (pos % align) {
+    fputc(0, f);
+    pos++;
+  }
+  return pos;
+}
+
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s <output.pak> <file or directory>...\n", argv[0]);
+    return 1;
+  }
+
+  for (int i = 2; i < argc; i++) {
+    if (!add_path(argv[i])) return 1;
+  }
+  qsort(assets, asset_count, sizeof(Asset), compare_assets);
+
+  for (int i = 1; i < asset_count; i++) {
+    if (strcmp(assets[i].path, assets[i - 1].path) == 0) {
+      fprintf(stderr, "Error: `%s` added more than once\n", assets[i].path);
+      return 1;
+    }
+  }
+
+  FILE *out = fopen(argv[1], "wb");
+  if (!out) {
+    fprintf(stderr, "Error: could not open `%s` for writing\n", argv[1]);
+    return 1;
+  }
+
+  // Leave room for the header, written last once offsets are known
+  S2D_PackHeader header;
+  memset(&header, 0, sizeof(header));
+  fwrite(&header, sizeof(header), 1, out);
+  uint64_t pos = sizeof(header);
+
+  // Asset data, each aligned
+  char buffer[64 * 1024];
+  for (int i = 0; i < asset_count; i++) {
+    Asset *a = &assets[i];
+    FILE *in = fopen(a->path, "rb");
+    if (!in) {
+      fprintf(stderr, "Error: could not read `%s`\n", a->path);
+      fclose(out);
+      return 1;
+    }
+
+    pos = pad_to(out, pos, PACK_ALIGN);
+    a->entry.offset = pos;
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+      fwrite(buffer, 1, n, out);
+      a->entry.size += n;
+    }
+    pos += a->entry.size;
+    fclose(in);
+  }
+
+  // Names
+  header.names_offset = pos;
+  for (int i = 0; i < asset_count; i++) {
+    Asset *a = &assets[i];
+    a->entry.name_offset = (uint32_t)(pos - header.names_offset);
+    a->entry.name_len = (uint32_t)strlen(a->path);
+    fwrite(a->path, 1, a->entry.name_len, out);
+    pos += a->entry.name_len;
+  }
+  header.names_size = pos - header.names_offset;
+
+  // Index, sorted by hash
+  pos = pad_to(out, pos, 8);
+  header.index_offset = pos;
+  for (int i = 0; i < asset_count; i++) {
+    fwrite(&assets[i].entry, sizeof(S2D_PackEntry), 1, out);
+  }
+
+  // Header
+  memcpy(header.magic, S2D_PACK_MAGIC, sizeof(S2D_PACK_MAGIC));
+  header.version = S2D_PACK_VERSION;
+  header.count = (uint32_t)asset_count;
+  fseek(out, 0, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, out);
+
+  if (fclose(out) != 0) {
+    fprintf(stderr, "Error: could not write `%s`\n", argv[1]);
+    return 1;
+  }
+
+  printf("Packed %d assets into `%s`\n", asset_count, argv[1]);
+  return 0;
+}